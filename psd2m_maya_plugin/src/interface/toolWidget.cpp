@@ -77,6 +77,7 @@ namespace maya_plugin
 		connect(Ui->depthModifierField, SIGNAL(valueChanged(double)), this, SLOT(SetDepthModifier(const double &)));
 		connect(Ui->meshScaleSlider, SIGNAL(valueChanged(int)), this, SLOT(SetMeshScale(const int &)));
 		connect(Ui->keepGroupStructureComboBox, SIGNAL(currentIndexChanged(int)), this, SLOT(SetActiveKeepGroup(int)));
+		connect(Ui->exportCompositeCheckBox, SIGNAL(toggled(bool)), this, SLOT(SetExportComposite(bool)));
 		connect(Ui->aliasPsdNameLineEdit, SIGNAL(textEdited(QString)), this, SLOT(SetAliasPsdName(QString)));
 		
 
@@ -89,6 +90,7 @@ namespace maya_plugin
 		// linear settings
 		connect(Ui->linearPrecisionField, SIGNAL(valueChanged(double)), this, SLOT(SetLinearPrecision(const double &)));
 		connect(Ui->gridOrientationDial, SIGNAL(valueChanged(int)), this, SLOT(SetGridDirection(int)));
+		connect(Ui->gridAutoOrientationCheckBox, SIGNAL(toggled(bool)), this, SLOT(SetGridAutoOrientation(bool)));
 
 		// curve settings
 		connect(Ui->mergeVertexDistanceField, SIGNAL(valueChanged(double)), this, SLOT(SetMergeDistance(const double &)));
@@ -117,11 +119,13 @@ namespace maya_plugin
 		disconnect(Ui->depthModifierField, SIGNAL(valueChanged(double)), this, SLOT(SetDepthModifier(const double &)));
 		disconnect(Ui->meshScaleSlider, SIGNAL(valueChanged(int)), this, SLOT(SetMeshScale(const int &)));
 		disconnect(Ui->keepGroupStructureComboBox, SIGNAL(currentIndexChanged(int)), this, SLOT(SetActiveKeepGroup(int)));
+		disconnect(Ui->exportCompositeCheckBox, SIGNAL(toggled(bool)), this, SLOT(SetExportComposite(bool)));
 		disconnect(Ui->aliasPsdNameLineEdit, SIGNAL(textEdited(QString)), this, SLOT(SetAliasPsdName(QString)));
 		disconnect(Ui->layerList, SIGNAL(itemSelectionChanged()), this, SLOT(SetSelectedLayers()));
 		disconnect(Ui->algoComboBox, SIGNAL(currentIndexChanged(int)), this, SLOT(SetAlgorithm(const int &)));
 		disconnect(Ui->linearPrecisionField, SIGNAL(valueChanged(double)), this, SLOT(SetLinearPrecision(const double &)));
 		disconnect(Ui->gridOrientationDial, SIGNAL(valueChanged(int)), this, SLOT(SetGridDirection(int)));
+		disconnect(Ui->gridAutoOrientationCheckBox, SIGNAL(toggled(bool)), this, SLOT(SetGridAutoOrientation(bool)));
 		disconnect(Ui->mergeVertexDistanceField, SIGNAL(valueChanged(double)), this, SLOT(SetMergeDistance(const double &)));
 		disconnect(Ui->minimalPolygonSizeField, SIGNAL(valueChanged(double)), this, SLOT(SetMinPolygonSize(const double &)));
 		disconnect(Ui->maximalPolygonSizeField, SIGNAL(valueChanged(double)), this, SLOT(SetMaxPolygonSize(const double &)));
@@ -288,6 +292,13 @@ namespace maya_plugin
 		this->Data.WriteValuesToJson();
 	}
 
+	//--------------------------------------------------------------------------------------------------------------------------------------
+	void ToolWidget::SetExportComposite(bool value)
+	{
+		this->Data.ExportComposite = value;
+		this->Data.WriteValuesToJson();
+	}
+
 	//--------------------------------------------------------------------------------------------------------------------------------------
 	void ToolWidget::SetAliasPsdName(const QString value)
 	{
@@ -321,6 +332,21 @@ namespace maya_plugin
 		this->Data.WriteValuesToJson();
 	}
 
+	//--------------------------------------------------------------------------------------------------------------------------------------
+	void ToolWidget::SetGridAutoOrientation(bool value)
+	{
+		for (const auto& item : Ui->layerList->selectedItems())
+		{
+			LayerParameters* params = GetLayerParameters(item);
+			params->LinearParameters.GridAutoOrientation = value;
+			params->UpdateDescription();
+		}
+
+		Ui->gridOrientationDial->setEnabled(!value);
+		Ui->gridOrientationField->setEnabled(!value);
+		this->Data.WriteValuesToJson();
+	}
+
 	//--------------------------------------------------------------------------------------------------------------------------------------
 	void ToolWidget::SetMergeDistance(const double& value)
 	{
@@ -515,6 +541,7 @@ namespace maya_plugin
 		// Check if values are different through layers
 		std::set<int> linearPrecision;
 		std::set<float> gridOrientation;
+		std::set<bool> gridAutoOrientation;
 		std::set<float> mergeVertex;
 		std::set<bool> influenceActivated;
 		std::set<float> minPolygonSize;
@@ -526,6 +553,7 @@ namespace maya_plugin
 
 			linearPrecision.insert(params->LinearParameters.LinearHeightPoly);
 			gridOrientation.insert(params->LinearParameters.GridOrientation);
+			gridAutoOrientation.insert(params->LinearParameters.GridAutoOrientation);
 			mergeVertex.insert(params->CurveParameters.MergeVertexDistance);
 			influenceActivated.insert(params->InfluenceActivated);
 			minPolygonSize.insert(params->InfluenceParameters.MinPolygonSize);
@@ -534,6 +562,7 @@ namespace maya_plugin
 
 		return  linearPrecision.size() > 1
 			|| gridOrientation.size() > 1
+			|| gridAutoOrientation.size() > 1
 			|| mergeVertex.size() > 1
 			|| influenceActivated.size() > 1
 			|| minPolygonSize.size() > 1
@@ -546,6 +575,7 @@ namespace maya_plugin
 		Ui->aliasPsdNameLineEdit->setText(this->Data.AliasPsdName);
 		Ui->depthModifierField->setValue(GetDephtUi());
 		Ui->keepGroupStructureComboBox->setCurrentIndex(this->Data.KeepGroupStructure);
+		Ui->exportCompositeCheckBox->setChecked(this->Data.ExportComposite);
 		Ui->meshScaleSlider->setValue(GetMeshScaleUi());
 
 		if (Ui->layerList->selectedItems().size() != 1)
@@ -556,6 +586,9 @@ namespace maya_plugin
 
 		Ui->linearPrecisionField->setValue(params->LinearParameters.LinearHeightPoly);
 		Ui->gridOrientationDial->setValue(params->LinearParameters.GridOrientation);
+		Ui->gridAutoOrientationCheckBox->setChecked(params->LinearParameters.GridAutoOrientation);
+		Ui->gridOrientationDial->setEnabled(!params->LinearParameters.GridAutoOrientation);
+		Ui->gridOrientationField->setEnabled(!params->LinearParameters.GridAutoOrientation);
 		Ui->mergeVertexDistanceField->setValue(params->CurveParameters.MergeVertexDistance);
 		Ui->influenceTitle->setChecked(params->InfluenceActivated);
 		Ui->minimalPolygonSizeField->setValue(params->InfluenceParameters.MinPolygonSize);
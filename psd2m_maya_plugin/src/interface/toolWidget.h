@@ -62,9 +62,11 @@ namespace maya_plugin
 		void SetAlgorithm(const int value);
 		void SetMeshScale(const int value);
 		void SetActiveKeepGroup(const int value);
+		void SetExportComposite(bool value);
 		void SetAliasPsdName(QString);
 		void SetLinearPrecision(const double value);
 		void SetGridDirection(const int value);
+		void SetGridAutoOrientation(bool value);
 		void SetMergeDistance(const double & value);
 		void SetActiveInfluence(bool value);
 		void SetMinPolygonSize(const double & value);
@@ -58,7 +58,7 @@ namespace maya_plugin
 		std::map<std::string, DataMesh> meshes;
 
 		// mesh creation
-		for (auto layer : data.LayerMaskData.Layers)
+		for (auto const& layer : data.LayerMaskData.Layers)
 		{
 			if (layer.Type > TEXTURE_LAYER)
 				continue;
@@ -72,10 +72,11 @@ namespace maya_plugin
 			{
 			case LayerParameters::Algorithm::LINEAR:
 			{
-				ResourceBlockPath blockPath = data.ImageResourceData.GetBlockPath(layer.LayerName);
+				ResourceBlockPath const& blockPath = data.ImageResourceData.GetBlockPath(layer.LayerName);
 				if (blockPath.Name.empty()) break;
 
-				meshes.try_emplace(layer.LayerName, GenerateDataLinearMesh(blockPath, layerParams));
+				const Vector2F canvasSize = Vector2F(float(data.HeaderData.Width), float(data.HeaderData.Height));
+				meshes.try_emplace(layer.LayerName, GenerateDataLinearMesh(blockPath, layerParams, canvasSize));
 				break;
 			}
 			case LayerParameters::Algorithm::CURVE:
@@ -100,7 +101,7 @@ namespace maya_plugin
 	void MeshGeneratorController::InitializeProgressBar(PsdData & data, GlobalParameters & params, Progress & progress)
 	{
 		unsigned n = 0;
-		for (auto layer : data.LayerMaskData.Layers)
+		for (auto const& layer : data.LayerMaskData.Layers)
 		{
 			if (layer.Type > TEXTURE_LAYER)
 				continue;
@@ -198,7 +199,7 @@ namespace maya_plugin
 		dagController.doIt();
 		
 		// Create the Transform structure base on the params option and photoshop group
-		for (auto layer : data.LayerMaskData.Layers)
+		for (auto const& layer : data.LayerMaskData.Layers)
 		{
 			if (params.KeepGroupStructure)
 			{
@@ -329,26 +330,29 @@ namespace maya_plugin
 #pragma region ALGORITHMS
 
 	//----------------------------------------------------------------------------------------
-	DataMesh MeshGeneratorController::GenerateDataLinearMesh(ResourceBlockPath const& resourceBlockPath, LayerParameters const* params)
+	DataMesh MeshGeneratorController::GenerateDataLinearMesh(ResourceBlockPath const& resourceBlockPath, LayerParameters const* params, Vector2F const& canvasSize)
 	{
-		std::vector<BezierCurve*> curves;
-		std::vector<Vector2F*> points;
+		std::vector<BezierCurve> curves;
+		std::vector<Vector2F> points;
 		boundingBox bounds = boundingBox();
 
 		// read bezier Curves
-		for (auto pathRecord : resourceBlockPath.PathRecords)
+		for (auto const& pathRecord : resourceBlockPath.PathRecords)
 		{
 			if (!pathRecord.IsClosedPath)
 			{
 				continue;
 			}
-			BezierCurve* tmpCurve = new BezierCurve();
-			tmpCurve->GenerateBezierCurve(pathRecord);
-			curves.push_back(tmpCurve);
-			points.insert(points.end(), tmpCurve->GetCurve().begin(), tmpCurve->GetCurve().end());
+			curves.emplace_back();
+			curves.back().GenerateBezierCurve(pathRecord, canvasSize);
+			points.insert(points.end(), curves.back().GetCurve().begin(), curves.back().GetCurve().end());
 		}
 
-		if ((int(params->LinearParameters.GridOrientation) % 90) != 0)
+		if (params->LinearParameters.GridAutoOrientation)
+		{
+			bounds.GenerateMinimalBoundingBox(points);
+		}
+		else if ((int(params->LinearParameters.GridOrientation) % 90) != 0)
 		{
 			bounds.SetOrientation(params->LinearParameters.GridOrientation);
 			bounds.GenerateOrientedBoundingBox(points);
@@ -407,6 +411,8 @@ namespace maya_plugin
 
 			MaskData maskData;
 			maskData.Data = TextureExporter::ConvertToMask(false, data.LayerMaskData.Layers[index], data.HeaderData.Width, data.HeaderData.Height, data.HeaderData.BitsPerPixel);
+			if (maskData.Data.empty())
+				continue;
 			maskData.Width = data.HeaderData.Width;
 			maskData.Height = data.HeaderData.Height;
 			maskData.BytesPerPixel = data.HeaderData.BitsPerPixel / 8;
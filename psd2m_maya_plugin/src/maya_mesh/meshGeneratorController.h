@@ -55,7 +55,7 @@ namespace maya_plugin
 		static void UpdateShapeEditorComponent(MObject& mFnMesh, MDagModifier& dag, GlobalParameters const& params,
 		                                DataMesh const& mesh, float);
 
-		static DataMesh GenerateDataLinearMesh(ResourceBlockPath const& resourceBlockPath, LayerParameters const* params);
+		static DataMesh GenerateDataLinearMesh(ResourceBlockPath const& resourceBlockPath, LayerParameters const* params, Vector2F const& canvasSize);
 		static DataMesh GenerateDataCurveGridMesh(LayerData const& layer, LayerParameters const* params);
 
 		static void ApplyInfluenceLayer(PsdData const& data, std::map<std::string, DataMesh>& meshes, GlobalParameters& params, Progress& progress);
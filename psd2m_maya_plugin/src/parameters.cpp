@@ -56,7 +56,7 @@ namespace maya_plugin
 		std::map<std::string, LayerParameters*> copy(this->NameLayerMap.begin(), this->NameLayerMap.end());
 		this->NameLayerMap.clear();
 
-		for (auto layer : psdData.LayerMaskData.Layers)
+		for (auto const& layer : psdData.LayerMaskData.Layers)
 		{
 			if (layer.Type > psd_reader::TEXTURE_LAYER)
 				continue;
@@ -157,6 +157,7 @@ namespace maya_plugin
 		this->Depth = 0;
 		this->Scale = 1;
 		this->KeepGroupStructure = true;
+		this->ExportComposite = false;
 		this->AliasPsdName = "";
 
 		this->ClearLayerParameters();
@@ -169,6 +170,8 @@ namespace maya_plugin
 		this->Scale = root[L"Scale"]->AsNumber();
 		this->AliasPsdName = MQtUtil::toQString(root[L"AliasPsdName"]->AsString().c_str());
 		this->KeepGroupStructure = root[L"KeepGroupStructure"]->AsBool();
+		auto exportComposite = root.find(L"ExportComposite");
+		this->ExportComposite = exportComposite != root.end() && exportComposite->second->AsBool();
 
 		this->ClearLayerParameters();
 		JSONArray layers = root[L"Layers"]->AsArray();
@@ -183,6 +186,9 @@ namespace maya_plugin
 			JSONObject linearParams = layerObject[L"LinearParameters"]->AsObject();
 			layerParams->LinearParameters.LinearHeightPoly = linearParams[L"LinearHeightPoly"]->AsNumber();
 			layerParams->LinearParameters.GridOrientation = linearParams[L"GridOrientation"]->AsNumber();
+			auto gridAutoOrientation = linearParams.find(L"GridAutoOrientation");
+			if (gridAutoOrientation != linearParams.end())
+				layerParams->LinearParameters.GridAutoOrientation = gridAutoOrientation->second->AsBool();
 
 			JSONObject curveParams = layerObject[L"CurveParameters"]->AsObject();
 			layerParams->CurveParameters.MergeVertexDistance = curveParams[L"MergeVertexDistance"]->AsNumber();
@@ -204,6 +210,7 @@ namespace maya_plugin
 		root[L"Scale"] = new JSONValue(this->Scale);
 		root[L"AliasPsdName"] = new JSONValue(StringToWString(MQtUtil::toMString(this->AliasPsdName).asChar()));
 		root[L"KeepGroupStructure"] = new JSONValue(this->KeepGroupStructure);
+		root[L"ExportComposite"] = new JSONValue(this->ExportComposite);
 
 		JSONArray layers;
 		for (auto pair : this->NameLayerMap)
@@ -217,6 +224,7 @@ namespace maya_plugin
 			JSONObject linearParams;
 			linearParams[L"LinearHeightPoly"] = new JSONValue(pair.second->LinearParameters.LinearHeightPoly);
 			linearParams[L"GridOrientation"] = new JSONValue(pair.second->LinearParameters.GridOrientation);
+			linearParams[L"GridAutoOrientation"] = new JSONValue(pair.second->LinearParameters.GridAutoOrientation);
 
 			JSONObject curveParams;
 			curveParams[L"MergeVertexDistance"] = new JSONValue(pair.second->CurveParameters.MergeVertexDistance);
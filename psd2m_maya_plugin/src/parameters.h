@@ -56,7 +56,7 @@ namespace maya_plugin
 		{
 			this->HasInfluenceLayer = psdData.LayerMaskData.GetIndexInfluenceLayer(layer.LayerName) != -1;
 			this->HasGlobalPath = psdData.ImageResourceData.IsPathExist(layer.LayerName);
-			this->HasVectorMask = !layer.PathRecords.empty();
+			this->HasVectorMask = !layer.PathRecords.Empty();
 		}
 
 		void UpdateDescription() const;
@@ -79,6 +79,7 @@ namespace maya_plugin
 		float Depth = 0;
 		float Scale = 1;
 		bool KeepGroupStructure = true;
+		bool ExportComposite = false; // Merged image written with the layer textures.
 		QString AliasPsdName = "";
 
 		// Layer Management
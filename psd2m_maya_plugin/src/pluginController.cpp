@@ -16,7 +16,9 @@
 
 #include <pluginController.h>
 #include <psd_reader/psdReader.h>
+#include <psd_reader/psdDiff.h>
 #include <QFileInfo>
+#include <QCoreApplication>
 
 #include "texture_exporter/textureExporter.h"
 #include "texture_exporter/lodepng.h"
@@ -37,6 +39,9 @@ namespace maya_plugin
 	//--------------------------------------------------------------------------------------------------------------------------------------
 	void PluginController::Update()
 	{
+		// Called again from the events processed during the parsing, the data isn't ready yet.
+		if (this->Parsing) return;
+
 		// Extrat the data from the view
 		GlobalParameters tmp = this->GuiPsdMaya->GetParameters();
 
@@ -65,6 +70,9 @@ namespace maya_plugin
 	//--------------------------------------------------------------------------------------------------------------------------------------
 	void PluginController::ParsePsdData(MString const& path)
 	{
+		// One parsing at a time, the running one owns its reader until it ends.
+		if (this->Parsing) return;
+
 		Progress progress = this->GuiPsdMaya->GetProgress();
 
 		std::function<void(unsigned)> initialize = [&progress](unsigned n) { progress.InitializeProgressBar(n); };
@@ -74,6 +82,10 @@ namespace maya_plugin
 
 		PsdReader reader(path.asChar());
 		reader.SetProgress(initialize, subInitialize, increment, completeSub);
+		// Every parsing is compared with the next one of the same file, see PsdDiff.
+		psd_reader::ReaderParameters parameters;
+		parameters.HashLayers = true;
+		reader.SetParameters(parameters);
 
 		// Create folder before the Parse starts
 		QFileInfo filePath(path.asChar());
@@ -81,15 +93,49 @@ namespace maya_plugin
 		if (!newFolder.exists())
 			_mkdir(MQtUtil::toMString(newFolder.absoluteFilePath()).asChar());
 
-		this->PsdData = reader.ParsePsd();
+		// The pixels are parsed into a new arena: the previous document stays in use by the events
+		// processed meanwhile and for the diff, its arena is freed when it is replaced.
+		this->Parsing = true;
+		psd_reader::ParseHandle parsing = reader.ParsePsdAsync();
+		while (!parsing.WaitFor(std::chrono::milliseconds(50)))
+		{
+			parsing.DrainProgress();
+			QCoreApplication::processEvents();
+		}
+		psd_reader::PsdData parsed = parsing.Get();
+		this->Parsing = false;
+
+		// The textures of the layers unchanged since the previous parsing of the same file stay valid.
+		const psd_reader::PsdDiff diff = psd_reader::PsdDiff::Compare(this->PsdData, parsed);
+		if (this->ParsedPath != path.asChar())
+		{
+			this->ExportedLayers.clear();
+		}
+		for (auto const& layer : diff.Layers)
+		{
+			if (layer.Change != psd_reader::LAYER_UNCHANGED) this->ExportedLayers.erase(layer.LayerName);
+		}
+		std::cout << "[PARSING PSD] Layers modified " << diff.Count(psd_reader::LAYER_MODIFIED) << ", added " << diff.Count(psd_reader::LAYER_ADDED)
+			<< ", removed " << diff.Count(psd_reader::LAYER_REMOVED) << ", unchanged " << diff.Count(psd_reader::LAYER_UNCHANGED) << std::endl;
+		this->ParsedPath = path.asChar();
+		this->PsdData = std::move(parsed);
 		this->GuiPsdMaya->SetPsdData(PsdData);
 
 		progress.CompleteProgressBar();
 	}
 
 	//--------------------------------------------------------------------------------------------------------------------------------------
-	void PluginController::ExportTexture(MString const& path) const
+	void PluginController::ExportTexture(MString const& path)
 	{
+		// The data is replaced at the end of the parsing.
+		if (this->Parsing) return;
+
+		if (this->ExportedPath != path.asChar())
+		{
+			this->ExportedLayers.clear();
+			this->ExportedPath = path.asChar();
+		}
+
 		std::vector<unsigned char> tmptexture;
 		this->GuiPsdMaya->GetProgress().InitializeProgressBar(PsdData.LayerMaskData.LayerCount);
 		for (int i = 0; i < PsdData.LayerMaskData.LayerCount; i++)
@@ -100,9 +146,22 @@ namespace maya_plugin
 			if (!layerParams->IsActive)
 				continue;
 
+			// Written by a previous export and unchanged since.
+			MString pngNameFile = MString(path + "/" + PsdData.LayerMaskData.Layers[i].LayerName.c_str() + ".png");
+			if (this->ExportedLayers.count(PsdData.LayerMaskData.Layers[i].LayerName) && QFileInfo::exists(pngNameFile.asChar()))
+			{
+				this->GuiPsdMaya->GetProgress().IncrementProgressBar();
+				continue;
+			}
+
 			tmptexture.clear();
 			tmptexture = TextureExporter::ConvertIffFormat(false, PsdData.LayerMaskData.Layers[i], PsdData.HeaderData.Width, PsdData.HeaderData.Height, PsdData.HeaderData.BitsPerPixel);
-			if (tmptexture.empty()) continue;
+			if (tmptexture.empty())
+			{
+				// No color or alpha channel decoded for this layer.
+				this->GuiPsdMaya->GetProgress().IncrementProgressBar();
+				continue;
+			}
 			unsigned char* pngData;
 			size_t pngsize;
 
@@ -114,18 +173,58 @@ namespace maya_plugin
 				continue;
 			}
 
-			MString pngNameFile = MString(path + "/" + PsdData.LayerMaskData.Layers[i].LayerName.c_str() + ".png");
-			lodepng_save_file(pngData, pngsize, pngNameFile.asChar());
+			if (lodepng_save_file(pngData, pngsize, pngNameFile.asChar()) == 0)
+			{
+				this->ExportedLayers.insert(PsdData.LayerMaskData.Layers[i].LayerName);
+			}
+			free(pngData);
 
 			this->GuiPsdMaya->GetProgress().IncrementProgressBar();
 		}
 
+		if (this->GuiPsdMaya->GetParameters().ExportComposite)
+		{
+			ExportComposite(path);
+		}
+
 		this->GuiPsdMaya->GetProgress().CompleteProgressBar();
 	}
 
+	//--------------------------------------------------------------------------------------------------------------------------------------
+	void PluginController::ExportComposite(MString const& path) const
+	{
+		if (this->Parsing) return;
+
+		// The parsing for the layers leaves the merged image out, it is decoded only for the export.
+		PsdReader reader(this->ParsedPath);
+		psd_reader::ReaderParameters parameters;
+		parameters.StructureOnly = true;
+		parameters.DecodeComposite = true;
+		reader.SetParameters(parameters);
+		const psd_reader::PsdData data = reader.ParsePsd();
+		psd_reader::ImageData const& composite = data.ImageData;
+		if (composite.Rgba.empty())
+		{
+			std::cout << "[EXPORT] No merged image to export" << std::endl;
+			return;
+		}
+
+		unsigned char* pngData;
+		size_t pngsize;
+		const unsigned error = lodepng_encode32(&pngData, &pngsize, composite.Rgba.data(), composite.Width, composite.Height, composite.BitsPerPixel);
+		if (!error)
+		{
+			MString pngNameFile = MString(path + "/composite.png");
+			lodepng_save_file(pngData, pngsize, pngNameFile.asChar());
+			free(pngData);
+		}
+	}
+
 	//--------------------------------------------------------------------------------------------------------------------------------------
 	void PluginController::GenerateMesh(GlobalParameters & params)
 	{
+		if (this->Parsing) return;
+
 		MeshGeneratorController::GenerateMayaMeshes(this->PsdData, params, this->GuiPsdMaya->GetProgress());
 	}
 }
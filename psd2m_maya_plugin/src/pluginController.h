@@ -20,6 +20,8 @@
 #include "interface/toolWidget.h"
 #include "IControllerUpdate.h"
 #include "psd_reader/psdReader.h"
+#include <set>
+#include <string>
 
 namespace maya_plugin
 {
@@ -30,7 +32,8 @@ namespace maya_plugin
 		~PluginController();
 
 		void Update();
-		void ExportTexture(MString const& path) const;
+		void ExportTexture(MString const& path);
+		void ExportComposite(MString const& path) const;
 		void GenerateMesh(GlobalParameters & params);
 		void ParsePsdData(MString const& path);
 
@@ -38,6 +41,10 @@ namespace maya_plugin
 		
 		ToolWidget* GuiPsdMaya; // Maya interface
 		psd_reader::PsdData PsdData;
+		bool Parsing = false; // Maya keeps running its events while the PSD is parsed, every entry point returns meanwhile.
+		std::string ParsedPath;
+		std::string ExportedPath;
+		std::set<std::string> ExportedLayers; // Textures written and unchanged since, by layer name.
 	};
 }
 #endif // PLUGINCONTROLLER_H
@@ -26,7 +26,11 @@ namespace maya_plugin
 	{
 		const int bytesPerPixel = depth / 8;
 		std::vector<unsigned char> textureIff;
-		if (layer.NbrChannel < 4) return textureIff;
+		unsigned char* const red = layer.GetChannelContent(0);
+		unsigned char* const green = layer.GetChannelContent(1);
+		unsigned char* const blue = layer.GetChannelContent(2);
+		unsigned char* const alpha = layer.GetChannelContent(-1);
+		if (red == nullptr || green == nullptr || blue == nullptr || alpha == nullptr) return textureIff;
 		auto const length = (layer.AnchorBottom - layer.AnchorTop) * (layer.AnchorRight - layer.AnchorLeft);
 		textureIff.reserve(width * height * 4 * bytesPerPixel);
 
@@ -60,17 +64,17 @@ namespace maya_plugin
 
 					for (int k = 0; k < bytesPerPixel; k++)
 					{
-						textureIff.push_back(layer.ImageContent[1][pos + k]);
+						textureIff.push_back(red[pos + k]);
 					}
 					for (int k = 0; k < bytesPerPixel; k++)
 					{
-						textureIff.push_back(layer.ImageContent[2][pos + k]);
+						textureIff.push_back(green[pos + k]);
 					}for (int k = 0; k < bytesPerPixel; k++)
 					{
-						textureIff.push_back(layer.ImageContent[3][pos + k]);
+						textureIff.push_back(blue[pos + k]);
 					}for (int k = 0; k < bytesPerPixel; k++)
 					{
-						textureIff.push_back(layer.ImageContent[0][pos + k]);
+						textureIff.push_back(alpha[pos + k]);
 					}
 					indexProgression += bytesPerPixel;
 				}
@@ -83,6 +87,9 @@ namespace maya_plugin
 	{
 		const int bytesPerPixel = depth / 8;
 		std::vector<unsigned char> maskTexture;
+		// Gray mask painted in the first colour channel, the only one decoded by default.
+		unsigned char* const gray = layer.GetChannelContent(0);
+		if (gray == nullptr) return maskTexture;
 		auto const length = (layer.AnchorBottom - layer.AnchorTop) * (layer.AnchorRight - layer.AnchorLeft);
 		maskTexture.reserve(width * height * bytesPerPixel);
 
@@ -113,7 +120,7 @@ namespace maya_plugin
 
 					for (int k = 0; k < bytesPerPixel; k++)
 					{
-						maskTexture.push_back(layer.ImageContent[1][pos + k]);
+						maskTexture.push_back(gray[pos + k]);
 					}
 					indexProgression += bytesPerPixel;
 				}
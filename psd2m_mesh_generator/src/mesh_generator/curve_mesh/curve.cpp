@@ -21,25 +21,23 @@ namespace mesh_generator
 #pragma region PUBLIC CURVE ACCESS
 
 	//----------------------------------------------------------------------------------------
-	Curve::Curve(PathRecord const& refPoint)
+	Curve::Curve(PathView const& refPoint)
 	{
-		this->PathPointsCurve = refPoint.Points;
 		this->IsClosedPath = refPoint.IsClosedPath;
+		if (refPoint.Size() == 0) return;
+
 		// Create all Bezier Segments
-		for (auto it = this->PathPointsCurve.cbegin(), end = this->PathPointsCurve.cend() - 1; it != end; ++it)
+		const size_t last = refPoint.Size() - 1;
+		for (size_t i = 0; i < last; ++i)
 		{
-			auto current = *it;
-			auto next = *(it + 1);
-			Bezier bez = Bezier(current->AnchorPoint, current->SegOut, next->SegIn, next->AnchorPoint);
+			Bezier bez = Bezier(refPoint.AnchorPoint(i), refPoint.SegOut(i), refPoint.SegIn(i + 1), refPoint.AnchorPoint(i + 1));
 			this->PathBezier.push_back(bez);
 		}
 
 		// If loop, create last segment
 		if (this->IsClosedPath)
 		{
-			auto current = *(this->PathPointsCurve.end() - 1);
-			auto next = *this->PathPointsCurve.begin();
-			Bezier bez = Bezier(current->AnchorPoint, current->SegOut, next->SegIn, next->AnchorPoint);
+			Bezier bez = Bezier(refPoint.AnchorPoint(last), refPoint.SegOut(last), refPoint.SegIn(0), refPoint.AnchorPoint(0));
 			this->PathBezier.push_back(bez);
 		}
 	}
@@ -31,14 +31,12 @@ namespace mesh_generator
 	{
 	public:
 		Curve() = default;
-		Curve(PathRecord const& refPoint);
+		Curve(PathView const& refPoint);
 
 		bool IsClosedPath;
 		const std::vector<Bezier>& GetBezierCurve() const { return this->PathBezier; }
-		std::vector<PathPoints*> GetPathPoints() const { return this->PathPointsCurve; }
 
 	private:
-		std::vector<PathPoints*> PathPointsCurve;
 		std::vector<Bezier> PathBezier;
 	};
 }
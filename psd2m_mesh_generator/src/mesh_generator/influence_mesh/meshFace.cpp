@@ -54,11 +54,11 @@ namespace mesh_generator
 	void MeshFace::SetShouldSubdivide(std::vector<Vector2F> const& vertices, MaskData const& influenceLayer, float minPolygonSize, float maxPolygonSize)
 	{
 		// Create bounding box
-		std::vector<Vector2F*> faceVertices;
+		std::vector<Vector2F> faceVertices;
+		faceVertices.reserve(this->Indices.size());
 		for (auto index : this->Indices)
 		{
-			Vector2F* v = new Vector2F(vertices[index].x, vertices[index].y);
-			faceVertices.push_back(v);
+			faceVertices.push_back(vertices[index]);
 		}
 
 		boundingBox box;
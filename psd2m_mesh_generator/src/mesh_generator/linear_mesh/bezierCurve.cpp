@@ -15,6 +15,8 @@
 //----------------------------------------------------------------------------------------------
 
 #include "bezierCurve.h"
+#include <algorithm>
+#include <cmath>
 
 namespace mesh_generator
 {
@@ -24,29 +26,17 @@ namespace mesh_generator
 	BezierCurve::BezierCurve() = default;
 
 	//----------------------------------------------------------------------------------------
-	BezierCurve::~BezierCurve()
+	void BezierCurve::GenerateBezierCurve(PathView const& refPoint, Vector2F const& canvasSize, float tolerance)
 	{
-		if (this->Curves.empty()) return;
+		this->Curve.clear();
 
-		for (auto& Curve : this->Curves)
+		if (refPoint.IsClosedPath && refPoint.Size() > 2)
 		{
-			delete Curve;
-		}
-		this->Curves.clear();
-	}
-
-	//----------------------------------------------------------------------------------------
-	void BezierCurve::GenerateBezierCurve(PathRecord const& refPoint)
-	{
-		if (!Curves.empty()) Curves.clear();
-
-		if (refPoint.IsClosedPath && refPoint.Points.size() > 2)
-		{
-			GenerateBezierClosedCurve(refPoint.Points);
+			GenerateBezierClosedCurve(refPoint, canvasSize, tolerance);
 		}
 		else
 		{
-			GenerateBezierOpenCurve(refPoint.Points);
+			GenerateBezierOpenCurve(refPoint, canvasSize, tolerance);
 		}
 	}
 
@@ -55,36 +45,27 @@ namespace mesh_generator
 #pragma region PRIVATE GENERATION
 
 	//----------------------------------------------------------------------------------------
-	void BezierCurve::GenerateBezierClosedCurve(std::vector<PathPoints*> const& refPoint)
+	void BezierCurve::GenerateBezierClosedCurve(PathView const& refPoint, Vector2F const& canvasSize, float tolerance)
 	{
-		unsigned int size = int(refPoint.size());
-		GenerateBezierOpenCurve(refPoint);
+		unsigned int size = int(refPoint.Size());
+		GenerateBezierOpenCurve(refPoint, canvasSize, tolerance);
 
 		// Connect the last point and the first point
-		for (float t = 0.0f; t <= 1.0f; )
-		{
-			Vector2F* pointCurve = BezierCurve::CalculateBezierPoint(t, *refPoint[size - 1], *refPoint[0]);
-			this->Curves.push_back(pointCurve);
-			t += 0.001f;
-		}
+		FlattenSegment(refPoint, size - 1, 0, canvasSize, tolerance);
 	}
 
 	//----------------------------------------------------------------------------------------
-	void BezierCurve::GenerateBezierOpenCurve(std::vector<PathPoints*> const& refPoint)
+	void BezierCurve::GenerateBezierOpenCurve(PathView const& refPoint, Vector2F const& canvasSize, float tolerance)
 	{
-		unsigned int size = int(refPoint.size());
+		unsigned int size = int(refPoint.Size());
 		// Not a path just one isolate point.
 		if (size <= 2) return;
 
-		// All the Points
+		// All the Points, the segments share their ends.
+		this->Curve.push_back(refPoint.AnchorPoint(0));
 		for (unsigned int i = 0; i < size - 1; ++i)
 		{
-			for (float t = 0.0f; t <= 1.0f; )
-			{
-				Vector2F* pointCurve = BezierCurve::CalculateBezierPoint(t, *refPoint[i], *refPoint[i + 1]);
-				this->Curves.push_back(pointCurve);
-				t += 0.005f;
-			}
+			FlattenSegment(refPoint, i, i + 1, canvasSize, tolerance);
 		}
 	}
 
@@ -93,28 +74,58 @@ namespace mesh_generator
 #pragma region POINTS
 
 	//----------------------------------------------------------------------------------------
-	// Implementation of this formule => [x,y]= ((1-t)^3 * p0 )+ 3 * (1-t)^2 * t * p1 ) + (3 * (1-t) * t^2 * p2) + (t^3 * p3)
+	// Wang's formula: n chords of equal parameter stay within the tolerance of the cubic when
+	// n >= sqrt(3 / 4 * max|p(i) - 2 p(i+1) + p(i+2)| / tolerance), measured in pixels.
 	//----------------------------------------------------------------------------------------
-	Vector2F* BezierCurve::CalculateBezierPoint(float const& t, Vector2F const& p0, Vector2F const& p1, Vector2F const& p2, Vector2F const& p3)
+	int BezierCurve::SegmentSteps(Vector2F const& p0, Vector2F const& p1, Vector2F const& p2, Vector2F const& p3, Vector2F const& canvasSize, float tolerance)
 	{
-		float u = 1.0f - t;
-		float tt = t * t;
-		float uu = u * u;
-		float uuu = uu * u;
-		float ttt = tt * t;
-
-		Vector2F* p = new Vector2F();
-		*p = p0 * uuu;					//first term (1-t)^3 * p0
-		*p += p1 * 3 * uu * t;			//second term 3(1-t)^2 * t*p1 
-		*p += p2 * 3 * u * tt;			//third term (3(1-t) * t^2 * p2)
-		*p += p3 * ttt;					//fourth term (t^3 * p3)
-		return p;
+		const Vector2F d0 = p0 - (p1 * 2.0f) + p2;
+		const Vector2F d1 = p1 - (p2 * 2.0f) + p3;
+		const float x0 = d0.x * canvasSize.x, y0 = d0.y * canvasSize.y;
+		const float x1 = d1.x * canvasSize.x, y1 = d1.y * canvasSize.y;
+		const float flatness = std::sqrt(std::max(x0 * x0 + y0 * y0, x1 * x1 + y1 * y1));
+
+		const float steps = std::ceil(std::sqrt(0.75f * flatness / std::max(tolerance, 1e-3f)));
+		// Also catches a NaN from a broken path.
+		if (!(steps >= 1.0f)) return 1;
+		return int(std::min(steps, 4096.0f));
 	}
 
 	//----------------------------------------------------------------------------------------
-	Vector2F* BezierCurve::CalculateBezierPoint(float const& t, PathPoints const& p0, PathPoints const& p1) const
+	// Forward differencing of [x,y]= ((1-t)^3 * p0 )+ 3 * (1-t)^2 * t * p1 ) + (3 * (1-t) * t^2 * p2) + (t^3 * p3)
+	// written as a*t^3 + b*t^2 + c*t + p0, three additions per point.
+	//----------------------------------------------------------------------------------------
+	void BezierCurve::FlattenSegment(PathView const& path, size_t i0, size_t i1, Vector2F const& canvasSize, float tolerance)
 	{
-		return BezierCurve::CalculateBezierPoint(t, p0.AnchorPoint, p0.SegOut, p1.SegIn, p1.AnchorPoint);
+		const Vector2F p0 = path.AnchorPoint(i0);
+		const Vector2F p1 = path.SegOut(i0);
+		const Vector2F p2 = path.SegIn(i1);
+		const Vector2F p3 = path.AnchorPoint(i1);
+
+		const int steps = SegmentSteps(p0, p1, p2, p3, canvasSize, tolerance);
+		const float h = 1.0f / float(steps);
+		const float hh = h * h;
+		const float hhh = hh * h;
+
+		const Vector2F a = (p3 - p0) + ((p1 - p2) * 3.0f);
+		const Vector2F b = (p0 - (p1 * 2.0f) + p2) * 3.0f;
+		const Vector2F c = (p1 - p0) * 3.0f;
+
+		Vector2F point = p0;
+		Vector2F delta1 = (a * hhh) + (b * hh) + (c * h);
+		Vector2F delta2 = (a * (6.0f * hhh)) + (b * (2.0f * hh));
+		const Vector2F delta3 = a * (6.0f * hhh);
+
+		this->Curve.reserve(this->Curve.size() + steps);
+		for (int i = 1; i < steps; ++i)
+		{
+			point += delta1;
+			delta1 += delta2;
+			delta2 += delta3;
+			this->Curve.push_back(point);
+		}
+		// The end from the path itself, no rounding drift on the joints.
+		this->Curve.push_back(p3);
 	}
 
 #pragma endregion
@@ -26,23 +26,28 @@ using namespace util;
 namespace mesh_generator
 {
 	//----------------------------------------------------------------------------------------------
+	// Path flattened in chords, each segment is cut just enough to stay within the tolerance.
 	class BezierCurve
 	{
 	public:
+		// Distance in pixels of the canvas between the chords and the curve.
+		static constexpr float DEFAULT_TOLERANCE = 0.25f;
+
 		BezierCurve();
-		~BezierCurve();
 
-		const std::vector<Vector2F*>& GetCurve() const { return this->Curves; };
-		int GetCurveSize() const { return int(Curves.size()); };
-		void GenerateBezierCurve(PathRecord const& refPoint);
+		const std::vector<Vector2F>& GetCurve() const { return this->Curve; };
+		int GetCurveSize() const { return int(Curve.size()); };
+		// The path is in fractions of the canvas, canvasSize converts it to pixels for the tolerance.
+		void GenerateBezierCurve(PathView const& refPoint, Vector2F const& canvasSize, float tolerance = DEFAULT_TOLERANCE);
 
 	private:
-		std::vector<Vector2F*> Curves;
+		std::vector<Vector2F> Curve;
 
-		static Vector2F* CalculateBezierPoint(float const& t, Vector2F const& p0, Vector2F const& p1, Vector2F const& p2, Vector2F const& p3);
-		Vector2F* CalculateBezierPoint(float const& t, PathPoints const& p0, PathPoints const& p1) const;
-		void GenerateBezierClosedCurve(std::vector<PathPoints*> const& refPoint);
-		void GenerateBezierOpenCurve(std::vector<PathPoints*> const& refPoint);
+		static int SegmentSteps(Vector2F const& p0, Vector2F const& p1, Vector2F const& p2, Vector2F const& p3, Vector2F const& canvasSize, float tolerance);
+		// Segment from the point i0 to the point i1 of the path, without its first point.
+		void FlattenSegment(PathView const& path, size_t i0, size_t i1, Vector2F const& canvasSize, float tolerance);
+		void GenerateBezierClosedCurve(PathView const& refPoint, Vector2F const& canvasSize, float tolerance);
+		void GenerateBezierOpenCurve(PathView const& refPoint, Vector2F const& canvasSize, float tolerance);
 	};
 }
 #endif // BEZIERCURVE_H
@@ -18,6 +18,7 @@
 #include <iostream>
 #include <string>
 #include <algorithm>
+#include <limits>
 
 namespace mesh_generator
 {
@@ -43,17 +44,17 @@ namespace mesh_generator
 #pragma region CALCUL BOUNDS
 
 	//----------------------------------------------------------------------------------------
-	void boundingBox::GenerateBoundingBox(std::vector<Vector2F*> const& pathPoints)
+	void boundingBox::GenerateBoundingBox(std::vector<Vector2F> const& pathPoints)
 	{
 		Vector2F min = Vector2F(1.0f, 1.0f);
 		Vector2F max = Vector2F(0.0f, 0.0f);
 
-		for (int i = -0; i < pathPoints.size(); i++)
+		for (auto const& point : pathPoints)
 		{
-			min.x = std::min(min.x, pathPoints[i]->x);
-			min.y = std::min(min.y, pathPoints[i]->y);
-			max.x = std::max(max.x, pathPoints[i]->x);
-			max.y = std::max(max.y, pathPoints[i]->y);
+			min.x = std::min(min.x, point.x);
+			min.y = std::min(min.y, point.y);
+			max.x = std::max(max.x, point.x);
+			max.y = std::max(max.y, point.y);
 		}
 
 		this->Points[0] = Vector2F(min.x, max.y); // top left;
@@ -82,17 +83,17 @@ namespace mesh_generator
 #pragma region ORIENTED BOUNDING BOX FROM OPEN VECTOR
 
 	//----------------------------------------------------------------------------------------------
-	void boundingBox::GetDirection(std::vector<PathPoints*> const& refPoint)
+	void boundingBox::GetDirection(PathView const& refPoint)
 	{
-		unsigned int size = int(refPoint.size());
+		unsigned int size = int(refPoint.Size());
 		// Not a path just one isolate point.
 		if (size < 2) return;
 
-		Vector2F* firstPoint = new Vector2F(refPoint[0]->AnchorPoint.x, refPoint[0]->AnchorPoint.y);
-		Vector2F* lastPoint = new Vector2F(refPoint[size - 1]->AnchorPoint.x, refPoint[size - 1]->AnchorPoint.y);
+		const Vector2F firstPoint = refPoint.AnchorPoint(0);
+		const Vector2F lastPoint = refPoint.AnchorPoint(size - 1);
 
-		this->OrientedVector[0] = firstPoint->x < lastPoint->x ? *firstPoint : *lastPoint;
-		this->OrientedVector[1] = firstPoint->x < lastPoint->x ? *lastPoint : *firstPoint;
+		this->OrientedVector[0] = firstPoint.x < lastPoint.x ? firstPoint : lastPoint;
+		this->OrientedVector[1] = firstPoint.x < lastPoint.x ? lastPoint : firstPoint;
 	}
 
 	//----------------------------------------------------------------------------------------------
@@ -103,9 +104,9 @@ namespace mesh_generator
 	}
 
 	//----------------------------------------------------------------------------------------------
-	void boundingBox::SetOrientation(PathRecord const& refPoint)
+	void boundingBox::SetOrientation(PathView const& refPoint)
 	{
-		this->GetDirection(refPoint.Points);
+		this->GetDirection(refPoint);
 	}
 
 	//----------------------------------------------------------------------------------------------
@@ -115,7 +116,7 @@ namespace mesh_generator
 	}
 
 	//----------------------------------------------------------------------------------------------
-	void boundingBox::GenerateOrientedBoundingBox(std::vector<Vector2F*> const& pathPoints)
+	void boundingBox::GenerateOrientedBoundingBox(std::vector<Vector2F> const& pathPoints)
 	{
 		// determine orientation and find the orthogonal vector
 		Vector2F pointOrthogonal;
@@ -141,13 +142,13 @@ namespace mesh_generator
 		float maxDistSeconde = -50.0f;
 		float tmpVal = 0.f;
 
-		for (int i = 0; i < pathPoints.size(); i++)
+		for (auto const& point : pathPoints)
 		{
-			tmpVal = (firstNormalizedVector.x * pathPoints[i]->x) + (firstNormalizedVector.y * pathPoints[i]->y);
+			tmpVal = (firstNormalizedVector.x * point.x) + (firstNormalizedVector.y * point.y);
 			minDistFirst = std::min(tmpVal, minDistFirst);
 			maxDistFirst = std::max(tmpVal, maxDistFirst);
 
-			tmpVal = (SecondeNormalizedVector.x * pathPoints[i]->x) + (SecondeNormalizedVector.y * pathPoints[i]->y);
+			tmpVal = (SecondeNormalizedVector.x * point.x) + (SecondeNormalizedVector.y * point.y);
 			minDistSeconde = std::min(tmpVal, minDistSeconde);
 			maxDistSeconde = std::max(tmpVal, maxDistSeconde);
 		}
@@ -181,8 +182,8 @@ namespace mesh_generator
 		int k = 0;
 		std::vector<Vector2F> H(2 * n);
 
-		// Sort Points lexicographically
-		sort(points.begin(), points.end());
+		// Sort Points lexicographically, Vector2F::operator< only compares x
+		sort(points.begin(), points.end(), [](Vector2F const& a, Vector2F const& b) { return a.x < b.x || (a.x == b.x && a.y < b.y); });
 
 		// Build lower hull
 		for (int i = 0; i < n; ++i) {
@@ -200,5 +201,95 @@ namespace mesh_generator
 		return H;
 	}
 
+	//----------------------------------------------------------------------------------------
+	// Rotating calipers: the smallest box has a side along an edge of the hull. For each edge in
+	// turn, the points farthest along it, away from it and back along it only move forward
+	// around the hull, from where they were for the previous edge.
+	// Returns the direction of the longest side of that box.
+	//----------------------------------------------------------------------------------------
+	Vector2F boundingBox::MinimalAreaAxis(std::vector<Vector2F> const& hull)
+	{
+		const size_t n = hull.size();
+		auto next = [n](size_t i) { return (i + 1) % n; };
+		auto dot = [](Vector2F const& a, Vector2F const& b) { return a.x * b.x + a.y * b.y; };
+		auto cross = [](Vector2F const& a, Vector2F const& b) { return a.x * b.y - a.y * b.x; };
+
+		size_t right = 0;
+		size_t top = 0;
+		size_t left = 0;
+		float bestArea = std::numeric_limits<float>::max();
+		Vector2F bestAxis = Vector2F(0.0f, 1.0f);
+
+		for (size_t i = 0; i < n; ++i)
+		{
+			const Vector2F edge = hull[next(i)] - hull[i];
+			const float length = edge.Magnitude();
+			if (length <= 0.0f) continue;
+			const Vector2F direction = edge / length;
+
+			// The hull is counterclockwise, the inside on the left of the edges.
+			if (i == 0) right = i;
+			while (dot(direction, hull[next(right)] - hull[right]) > 0) right = next(right);
+			if (i == 0) top = right;
+			while (cross(direction, hull[next(top)] - hull[top]) > 0) top = next(top);
+			if (i == 0) left = top;
+			while (dot(direction, hull[next(left)] - hull[left]) < 0) left = next(left);
+
+			const float width = dot(direction, hull[right] - hull[left]);
+			const float height = cross(direction, hull[top] - hull[i]);
+			if (width * height < bestArea)
+			{
+				bestArea = width * height;
+				bestAxis = width >= height ? direction : Vector2F(-direction.y, direction.x);
+			}
+		}
+		return bestAxis;
+	}
+
+	//----------------------------------------------------------------------------------------
+	void boundingBox::GenerateMinimalBoundingBox(std::vector<Vector2F> const& pathPoints)
+	{
+		std::vector<Vector2F> points = pathPoints;
+		std::vector<Vector2F> hull = points.size() >= 3 ? ConvexHull(points) : std::vector<Vector2F>();
+
+		// The flattened straight sides leave points barely off their line in the hull, whose short
+		// edges would tilt the box: only the corners choose the axis. The points dropped with the
+		// others stay inside the box, which is fitted to all of them.
+		if (hull.size() >= 3)
+		{
+			Vector2F lower = hull[0];
+			Vector2F upper = hull[0];
+			for (Vector2F const& point : hull)
+			{
+				lower = Vector2F(std::min(lower.x, point.x), std::min(lower.y, point.y));
+				upper = Vector2F(std::max(upper.x, point.x), std::max(upper.y, point.y));
+			}
+			const double extent = std::max(upper.x - lower.x, upper.y - lower.y);
+			const double tolerance = 1e-5 * extent * extent;
+			std::vector<Vector2F> corners;
+			for (size_t i = 0; i < hull.size(); ++i)
+			{
+				Vector2F const& previous = corners.empty() ? hull.back() : corners.back();
+				if (Cross(previous, hull[i], hull[(i + 1) % hull.size()]) > tolerance) corners.push_back(hull[i]);
+			}
+			hull.swap(corners);
+		}
+		if (hull.size() < 3)
+		{
+			GenerateBoundingBox(pathPoints);
+			return;
+		}
+
+		// GenerateOrientedBoundingBox takes the height of the box along the direction when it goes
+		// up, and across it otherwise: the height, which the rows divide, is the longest side.
+		const Vector2F axis = MinimalAreaAxis(hull);
+		this->OrientedVector[0] = Vector2F(0.0f, 0.0f);
+		if (axis.y > 0.0f) this->OrientedVector[1] = axis;
+		else if (axis.y < 0.0f) this->OrientedVector[1] = axis * -1.0f;
+		else this->OrientedVector[1] = Vector2F(0.0f, -1.0f);
+
+		GenerateOrientedBoundingBox(pathPoints);
+	}
+
 #pragma endregion
 }
@@ -36,11 +36,13 @@ namespace mesh_generator
 		Vector2F BottomRightPoint();
 		Vector2F GetCenter() { return Vector2F::Mid(TopLeftPoint(), BottomRightPoint()); }
 
-		void GenerateBoundingBox(std::vector<Vector2F*> const& pathPoints);
+		void GenerateBoundingBox(std::vector<Vector2F> const& pathPoints);
 		void DisplayBoundingBox() const;
-		void SetOrientation(PathRecord const& refPoint);
+		void SetOrientation(PathView const& refPoint);
 		void SetOrientation(float const angle);
-		void GenerateOrientedBoundingBox(std::vector<Vector2F*> const& pathPoints);
+		void GenerateOrientedBoundingBox(std::vector<Vector2F> const& pathPoints);
+		// Smallest box of any orientation, its height along its longest side.
+		void GenerateMinimalBoundingBox(std::vector<Vector2F> const& pathPoints);
 
 	private:
 		Vector2F Points[4];
@@ -49,7 +51,8 @@ namespace mesh_generator
 
 		static double Cross(Vector2F const& o, Vector2F const& a, Vector2F const& b);
 		std::vector<Vector2F> ConvexHull(std::vector<Vector2F>& points);
-		void GetDirection(std::vector<PathPoints*> const& refPoint);
+		static Vector2F MinimalAreaAxis(std::vector<Vector2F> const& hull);
+		void GetDirection(PathView const& refPoint);
 		void GetDirection(float angle);
 	};
 }
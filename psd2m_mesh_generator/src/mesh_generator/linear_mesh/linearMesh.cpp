@@ -15,50 +15,134 @@
 //----------------------------------------------------------------------------------------------
 
 #include "linearMesh.h"
+#include <algorithm>
 #include <cmath>
+#include <limits>
 
 namespace mesh_generator
 {
 
-#pragma region MESH POLY
+#pragma region CELL GRID
 
 	//----------------------------------------------------------------------------------------
-	std::vector<int> MeshPoly::GetVertexIndexes()
+	CellGrid::CellGrid(int rowCount, int columnCount, bool narrowBand) : RowCount(rowCount), ColumnCount(columnCount), NarrowBand(narrowBand)
 	{
-		std::vector<int> indexes;
-		for (auto i = 0; i < std::size(this->Vertex); i++)
+		if (narrowBand)
 		{
-			if (this->Vertex[i] == nullptr || this->Vertex[i]->Index == -1) continue;
-			indexes.push_back(Vertex[i]->Index);
+			this->BandRows.resize(rowCount);
+		}
+		else
+		{
+			this->Splits.assign(size_t(rowCount) * columnCount, 0);
 		}
-		return indexes;
 	}
 
-#pragma endregion
+	//----------------------------------------------------------------------------------------
+	unsigned char* CellGrid::FindBand(int row, int column)
+	{
+		auto& cells = this->BandRows[row];
+		auto it = std::lower_bound(cells.begin(), cells.end(), column, [](std::pair<int, unsigned char> const& cell, int value) { return cell.first < value; });
+		return it != cells.end() && it->first == column ? &it->second : nullptr;
+	}
 
-#pragma region  GENERATION
+	//----------------------------------------------------------------------------------------
+	const unsigned char* CellGrid::FindBand(int row, int column) const
+	{
+		return const_cast<CellGrid*>(this)->FindBand(row, column);
+	}
 
 	//----------------------------------------------------------------------------------------
-	DataMesh LinearMesh::GenerateMesh(std::string const& name, LinearParameters const& params, boundingBox& bounds, std::vector<BezierCurve*> curves)
+	unsigned char CellGrid::GetSplit(int row, int column) const
 	{
-		GlobalParameters* paramsGeneration = new GlobalParameters(name, params);
+		if (!this->NarrowBand) return this->Splits[Key(row, column)];
 
-		MeshVertex** grid = GenerateGrid(bounds, paramsGeneration);
-		std::vector<MeshPoly*> polys = FilterGrid(grid, curves, bounds, paramsGeneration);
-		DataMesh mesh = BuildDataMesh(grid, polys, paramsGeneration);
+		const unsigned char* sides = FindBand(row, column);
+		return sides != nullptr ? *sides : 0;
+	}
 
-		// Clean
-		polys.clear();
+	//----------------------------------------------------------------------------------------
+	void CellGrid::AddSplit(int row, int column, unsigned char sides)
+	{
+		if (!this->NarrowBand)
+		{
+			this->Splits[Key(row, column)] |= sides;
+			return;
+		}
+		// Sorted and merged by Seal.
+		this->BandRows[row].emplace_back(column, sides);
+	}
 
-		if (grid != nullptr)
+	//----------------------------------------------------------------------------------------
+	void CellGrid::RemoveSplit(int row, int column, unsigned char sides)
+	{
+		if (!this->NarrowBand)
 		{
-			for (auto i = 0; i < paramsGeneration->RowCount; i++)
+			this->Splits[Key(row, column)] &= ~sides;
+			return;
+		}
+		unsigned char* current = FindBand(row, column);
+		if (current != nullptr) *current &= ~sides;
+	}
+
+	//----------------------------------------------------------------------------------------
+	CellIntersection CellGrid::GetIntersection(int row, int column) const
+	{
+		auto it = this->Intersections.find(Key(row, column));
+		return it != this->Intersections.end() ? it->second : CellIntersection();
+	}
+
+	//----------------------------------------------------------------------------------------
+	void CellGrid::SetRightIntersection(int row, int column, Vector2F const& point)
+	{
+		this->Intersections[Key(row, column)].Right = point;
+	}
+
+	//----------------------------------------------------------------------------------------
+	void CellGrid::SetBottomIntersection(int row, int column, Vector2F const& point)
+	{
+		this->Intersections[Key(row, column)].Bottom = point;
+	}
+
+	//----------------------------------------------------------------------------------------
+	void CellGrid::Seal()
+	{
+		if (!this->NarrowBand) return;
+
+		for (auto& cells : this->BandRows)
+		{
+			std::sort(cells.begin(), cells.end(), [](std::pair<int, unsigned char> const& a, std::pair<int, unsigned char> const& b) { return a.first < b.first; });
+			size_t count = 0;
+			for (auto const& cell : cells)
 			{
-				delete[] grid[i];
+				if (count > 0 && cells[count - 1].first == cell.first)
+				{
+					cells[count - 1].second |= cell.second;
+					continue;
+				}
+				cells[count++] = cell;
 			}
-			delete[] grid;
+			cells.resize(count);
+			cells.shrink_to_fit();
+		}
+	}
+
+#pragma endregion
+
+#pragma region  GENERATION
+
+	//----------------------------------------------------------------------------------------
+	DataMesh LinearMesh::GenerateMesh(std::string const& name, LinearParameters const& params, boundingBox& bounds, std::vector<BezierCurve> const& curves)
+	{
+		GlobalParameters* paramsGeneration = new GlobalParameters(name, params);
+
+		MeshGrid grid = GenerateGrid(bounds, paramsGeneration);
+		std::vector<int> polys;
+		if (!grid.Positions.empty())
+		{
+			polys = FilterGrid(grid, curves, bounds, paramsGeneration);
 		}
-		
+		DataMesh mesh = BuildDataMesh(grid, polys, paramsGeneration);
+
 		delete paramsGeneration;
 
 		return mesh;
@@ -71,9 +155,9 @@ namespace mesh_generator
 	//----------------------------------------------------------------------------------------
 	// Create the initial grid of polygon from the bounding box
 	//----------------------------------------------------------------------------------------
-	MeshVertex** LinearMesh::GenerateGrid(boundingBox & bounds, GlobalParameters* paramsGeneration)
+	MeshGrid LinearMesh::GenerateGrid(boundingBox & bounds, GlobalParameters* paramsGeneration)
 	{
-		MeshVertex** grid = nullptr;
+		MeshGrid grid;
 		if (paramsGeneration->GetPrecision() <= 0.0f) return grid;
 
 		const Vector2F topLeft = bounds.TopLeftPoint();
@@ -86,7 +170,7 @@ namespace mesh_generator
 		const int nColumn = int(ceil(Vector2F::Magnitude(topLeft, topRight) / paramsGeneration->Precision) + 3);
 		const int nRow = int(ceil(Vector2F::Magnitude(topLeft, bottomLeft) / paramsGeneration->Precision) + 3);
 
-		grid = new MeshVertex*[nRow];
+		grid.Positions.resize(size_t(nRow) * nColumn);
 
 		// Get the projection and keep the extreme point
 		float r0 = sqrt(powf((topRight.x - topLeft.x), 2.0) + powf((topRight.y - topLeft.y), 2.0));
@@ -102,45 +186,53 @@ namespace mesh_generator
 		paramsGeneration->GeneratedBottomRight = paramsGeneration->GeneratedTopRight + (paramsGeneration->VectNormalV *  float(nRow));
 		paramsGeneration->GeneratedBottomLeft = initPos + (paramsGeneration->VectNormalV * float(nRow));
 
-		// For each row set the postion of all column vertice.
+		// The origin of each row first, accumulated from top to bottom, then the rows in parallel.
+		std::vector<Vector2F> rowOrigins(nRow);
 		for (int row = 0; row < nRow; row++)
 		{
-			grid[row] = new MeshVertex[nColumn];
+			rowOrigins[row] = initPos;
+			initPos += (paramsGeneration->VectNormalV * paramsGeneration->Precision); // Go from top to bottom
+		}
+
+		// For each row set the postion of all column vertice.
+		const Vector2F columnStep = paramsGeneration->VectNormalH * paramsGeneration->Precision;
+		Parallel::For(size_t(nRow), paramsGeneration->GetThreadCount(), [&](size_t row)
+		{
+			Vector2F* positions = &grid.Positions[row * nColumn];
 
 			for (int column = 0; column < nColumn; column++)
 			{
-				grid[row][column].Position = initPos + (paramsGeneration->VectNormalH *paramsGeneration->Precision * (float)column); // Go From left to right
+				positions[column] = rowOrigins[row] + (columnStep * (float)column); // Go From left to right
 			}
-			initPos += (paramsGeneration->VectNormalV * paramsGeneration->Precision); // Go from top to bottom
-		}
+		});
 
+		grid.ColumnCount = nColumn;
+		grid.RowCount = nRow;
 		paramsGeneration->ColumnCount = nColumn;
 		paramsGeneration->RowCount = nRow;
 		return grid;
 	}
 
 	//----------------------------------------------------------------------------------------
-	std::vector<MeshPoly*> LinearMesh::FilterGrid(MeshVertex** initialGrid, const std::vector<BezierCurve*>& curves, boundingBox & bounds, GlobalParameters* paramsGeneration)
+	std::vector<int> LinearMesh::FilterGrid(MeshGrid& grid, const std::vector<BezierCurve>& curves, boundingBox & bounds, GlobalParameters* paramsGeneration)
 	{
-		MeshPoly ** polys = new MeshPoly*[paramsGeneration->RowCount - 1];
+		const long long cellCount = (long long)(grid.RowCount - 1) * (grid.ColumnCount - 1);
+		CellGrid cells(grid.RowCount - 1, grid.ColumnCount - 1, cellCount > NARROW_BAND_CELLS);
 
-		for (int row = 0; row < paramsGeneration->RowCount - 1; row++)
+		// The curves are followed in parallel, their crossings are then marked in the order of the
+		// curves, a later curve replacing the intersections of an earlier one as in a serial run.
+		std::vector<std::vector<GridCrossing>> crossings(curves.size());
+		Parallel::For(curves.size(), paramsGeneration->GetThreadCount(), [&](size_t index)
 		{
-			polys[row] = new MeshPoly[paramsGeneration->ColumnCount - 1];
-			for (int column = 0; column < paramsGeneration->ColumnCount - 1; column++)
-			{
-				polys[row][column].Vertex[0] = &initialGrid[row][column];
-				polys[row][column].Vertex[1] = &initialGrid[row][column + 1];
-				polys[row][column].Vertex[2] = &initialGrid[row + 1][column + 1];
-				polys[row][column].Vertex[3] = &initialGrid[row + 1][column];
-			}
-		}
-		for (auto it = curves.cbegin(); it != curves.cend(); it++)
+			IdentificationContourPoly(crossings[index], curves[index], bounds, paramsGeneration);
+		});
+		for (auto const& curveCrossings : crossings)
 		{
-			IdentificationContourPoly(polys, **it, bounds, paramsGeneration);
+			MarkCrossings(cells, curveCrossings);
 		}
-		CleanAloneSplit(polys, paramsGeneration);
-		return BuildPolyMesh(polys, paramsGeneration);
+		cells.Seal();
+		CleanAloneSplit(cells);
+		return BuildPolyMesh(grid, cells, paramsGeneration->GetThreadCount());
 	}
 
 	//----------------------------------------------------------------------------------------
@@ -158,70 +250,108 @@ namespace mesh_generator
 	}
 
 	//----------------------------------------------------------------------------------------
-	// TO DO: split and optimize.
+	// Amanatides-Woo traversal of the grid along each chord of the curve: every row or column
+	// line crossed is visited once, at the parameter where the chord meets it. Only reads the
+	// grid parameters, the curves can be followed in parallel.
 	//----------------------------------------------------------------------------------------
-	void LinearMesh::IdentificationContourPoly(MeshPoly** polys, BezierCurve const& curve, boundingBox & bounds, GlobalParameters* paramsGeneration)
+	void LinearMesh::IdentificationContourPoly(std::vector<GridCrossing>& crossings, BezierCurve const& curve, boundingBox & bounds, GlobalParameters* paramsGeneration)
 	{
-		Vector2F * currentPoint = curve.GetCurve()[0];
-		Vector2F * lastPoint;
+		std::vector<Vector2F> const& points = curve.GetCurve();
+		if (points.empty()) return;
 
 		const Vector2F vectH = Vector2F(paramsGeneration->GeneratedTopRight.x - paramsGeneration->GeneratedTopLeft.x, paramsGeneration->GeneratedTopRight.y - paramsGeneration->GeneratedTopLeft.y);
 		const Vector2F vectV = Vector2F(paramsGeneration->GeneratedBottomLeft.x - paramsGeneration->GeneratedTopLeft.x, paramsGeneration->GeneratedBottomLeft.y - paramsGeneration->GeneratedTopLeft.y);
 		const float magnitudeH = Vector2F::Magnitude(paramsGeneration->GeneratedTopRight, paramsGeneration->GeneratedTopLeft);
 		const float magnitudeV = Vector2F::Magnitude(paramsGeneration->GeneratedBottomLeft, paramsGeneration->GeneratedTopLeft);
+		const float never = std::numeric_limits<float>::infinity();
 
-		const Vector2F vectInitPoint = Vector2F(currentPoint->x - paramsGeneration->GeneratedTopLeft.x, currentPoint->y - paramsGeneration->GeneratedTopLeft.y);
-		float valProjH = ((vectH.x*vectInitPoint.x) + (vectH.y*vectInitPoint.y)) / magnitudeH;
-		float valProjV = ((vectV.x*vectInitPoint.x) + (vectV.y*vectInitPoint.y)) / magnitudeV;
-		int row = int(valProjV / paramsGeneration->Precision);
-		int column = int(valProjH / paramsGeneration->Precision);
+		// Position in the grid counted in cells, x for the columns and y for the rows.
+		auto toCell = [&](Vector2F const& point)
+		{
+			const Vector2F vectPoint = Vector2F(point.x - paramsGeneration->GeneratedTopLeft.x, point.y - paramsGeneration->GeneratedTopLeft.y);
+			const float valProjH = ((vectH.x*vectPoint.x) + (vectH.y*vectPoint.y)) / magnitudeH;
+			const float valProjV = ((vectV.x*vectPoint.x) + (vectV.y*vectPoint.y)) / magnitudeV;
+			return Vector2F(valProjH / paramsGeneration->Precision, valProjV / paramsGeneration->Precision);
+		};
+
+		// A NaN or infinite position, from a degenerate grid or curve, would keep the walk from
+		// advancing: the curve stops being followed there.
+		auto isFinite = [](Vector2F const& v) { return std::isfinite(v.x) && std::isfinite(v.y); };
+
+		Vector2F cellStart = toCell(points[0]);
+		if (!isFinite(cellStart)) return;
+		int row = int(cellStart.y);
+		int column = int(cellStart.x);
 
 		// Follow the Curve points
-		for (int i = 1; i < curve.GetCurveSize(); i++)
+		for (size_t i = 1; i < points.size(); i++)
 		{
-			lastPoint = currentPoint;
-			currentPoint = curve.GetCurve()[i];
-			
-			Vector2F Point = Vector2F(currentPoint->x - paramsGeneration->GeneratedTopLeft.x, currentPoint->y - paramsGeneration->GeneratedTopLeft.y);
-			float valProjH = ((vectH.x*Point.x) + (vectH.y*Point.y)) / magnitudeH;
-			float valProjV = ((vectV.x*Point.x) + (vectV.y*Point.y)) / magnitudeV;
-			int tmpRow = int(valProjV / paramsGeneration->Precision);
-			int tmpColumn = int(valProjH / paramsGeneration->Precision);
-
-			if(tmpRow != row)
+			const Vector2F chordStart = points[i - 1];
+			const Vector2F chord = points[i] - chordStart;
+			const Vector2F cellEnd = toCell(points[i]);
+			const Vector2F cellDelta = cellEnd - cellStart;
+			if (!isFinite(cellEnd) || !isFinite(cellDelta)) return;
+
+			// Parameter on the chord of the next column and row lines, from the current cell and not
+			// from the start point: a point on a line is only counted once between two chords.
+			const int stepColumn = cellDelta.x > 0 ? 1 : -1;
+			const int stepRow = cellDelta.y > 0 ? 1 : -1;
+			const float deltaColumn = cellDelta.x != 0 ? std::abs(1.0f / cellDelta.x) : never;
+			const float deltaRow = cellDelta.y != 0 ? std::abs(1.0f / cellDelta.y) : never;
+			float nextColumn = cellDelta.x != 0 ? (float(column + (stepColumn > 0 ? 1 : 0)) - cellStart.x) / cellDelta.x : never;
+			float nextRow = cellDelta.y != 0 ? (float(row + (stepRow > 0 ? 1 : 0)) - cellStart.y) / cellDelta.y : never;
+
+			while (std::min(nextColumn, nextRow) <= 1.0f)
 			{
-				// direction vers le bas
-				if(tmpRow > row)
+				// Both at once on a corner: the row first, then the column from the new row.
+				const bool crossRow = nextRow <= nextColumn;
+				const bool crossColumn = nextColumn <= nextRow;
+				const Vector2F intersection = chordStart + (chord * std::max(0.0f, std::min(nextColumn, nextRow)));
+
+				if (crossRow)
 				{
-					polys[row][column].BottomIntersection = *lastPoint;
-					polys[row][column].SideSplit[2] = true;
-					polys[tmpRow][column].SideSplit[0] = true;
+					// The crossed side is the bottom of the upper cell.
+					const int tmpRow = row + stepRow;
+					crossings.push_back({ std::min(row, tmpRow), column, true, intersection });
+					row = tmpRow;
+					nextRow += deltaRow;
 				}
-				else // direction vers le haut
+
+				if (crossColumn)
 				{
-					polys[tmpRow][column].BottomIntersection = *currentPoint;
-					polys[row][column].SideSplit[0] = true;
-					polys[tmpRow][column].SideSplit[2] = true;
+					// The crossed side is the right of the left cell.
+					const int tmpColumn = column + stepColumn;
+					crossings.push_back({ row, std::min(column, tmpColumn), false, intersection });
+					column = tmpColumn;
+					nextColumn += deltaColumn;
 				}
-				row = tmpRow;
 			}
+			cellStart = cellEnd;
+		}
+	}
+
+	//----------------------------------------------------------------------------------------
+	void LinearMesh::MarkCrossings(CellGrid& cells, std::vector<GridCrossing> const& crossings)
+	{
+		for (auto const& crossing : crossings)
+		{
+			// Rounding can put a contour point just past the outer lines of the grid, such a crossing
+			// has no cell on one of its sides and is dropped.
+			const int otherRow = crossing.AcrossRows ? crossing.Row + 1 : crossing.Row;
+			const int otherColumn = crossing.AcrossRows ? crossing.Column : crossing.Column + 1;
+			if (!cells.Contains(crossing.Row, crossing.Column) || !cells.Contains(otherRow, otherColumn)) continue;
 
-			if (tmpColumn != column)
+			if (crossing.AcrossRows)
 			{
-				// direction vers la droite
-				if (tmpColumn > column)
-				{
-					polys[row][column].RigthIntersection = *lastPoint;
-					polys[row][column].SideSplit[1] = true;
-					polys[row][tmpColumn].SideSplit[3] = true;
-				}
-				else // direction vers la gauche
-				{
-					polys[row][tmpColumn].RigthIntersection = *currentPoint;
-					polys[row][tmpColumn].SideSplit[1] = true;
-					polys[row][column].SideSplit[3] = true;
-				}
-				column = tmpColumn;
+				cells.SetBottomIntersection(crossing.Row, crossing.Column, crossing.Intersection);
+				cells.AddSplit(crossing.Row, crossing.Column, SPLIT_BOTTOM);
+				cells.AddSplit(crossing.Row + 1, crossing.Column, SPLIT_TOP);
+			}
+			else
+			{
+				cells.SetRightIntersection(crossing.Row, crossing.Column, crossing.Intersection);
+				cells.AddSplit(crossing.Row, crossing.Column, SPLIT_RIGHT);
+				cells.AddSplit(crossing.Row, crossing.Column + 1, SPLIT_LEFT);
 			}
 		}
 	}
@@ -231,16 +361,16 @@ namespace mesh_generator
 #pragma region FILTRATION
 
 	//----------------------------------------------------------------------------------------------
-	void LinearMesh::CleanAloneSplit(MeshPoly ** polys, GlobalParameters* paramsGeneration)
+	void LinearMesh::CleanAloneSplit(CellGrid& cells)
 	{
-		for (int row = 0; row < paramsGeneration->RowCount - 1; row++)
+		for (int row = 0; row < cells.GetRowCount(); row++)
 		{
-			for (int column = 0; column < paramsGeneration->ColumnCount - 1; column++)
+			cells.VisitRow(row, [&](int column, unsigned char sides)
 			{
 				int indexMemory = -1;
 				for (int i = 0; i < 4; i++)
 				{
-					if (!polys[row][column].SideSplit[i]) continue;
+					if (!(sides & (1 << i))) continue;
 					if (indexMemory >= 0)
 					{
 						indexMemory = -1;
@@ -248,43 +378,74 @@ namespace mesh_generator
 					}
 					indexMemory = i;
 				}
-				if (indexMemory == -1) continue;
+				if (indexMemory == -1) return;
 
-				polys[row][column].SideSplit[indexMemory] = false;
+				cells.RemoveSplit(row, column, sides);
 
-				if (indexMemory == 2 && row < paramsGeneration->RowCount - 1)
-					polys[row + 1][column].SideSplit[0] = false;
+				if (indexMemory == 2 && row + 1 < cells.GetRowCount())
+					cells.RemoveSplit(row + 1, column, SPLIT_TOP);
 
 				if (indexMemory == 3 && column - 1 > 0)
-					polys[row][column - 1].SideSplit[1] = false;
+					cells.RemoveSplit(row, column - 1, SPLIT_RIGHT);
 
-				if (indexMemory == 0 && row - 1 > 0) 
-					polys[row - 1][column].SideSplit[2] = false;
+				if (indexMemory == 0 && row - 1 > 0)
+					cells.RemoveSplit(row - 1, column, SPLIT_BOTTOM);
 
-				if (indexMemory == 1 && column < paramsGeneration->ColumnCount - 1) 
-					polys[row][column + 1].SideSplit[3] = false;
-			}
+				if (indexMemory == 1 && column + 1 < cells.GetColumnCount())
+					cells.RemoveSplit(row, column + 1, SPLIT_LEFT);
+			});
 		}
 	}
 
 	//----------------------------------------------------------------------------------------------
-	std::vector<MeshPoly*> LinearMesh::BuildPolyMesh(MeshPoly ** polys, GlobalParameters* paramsGeneration)
+	// The polys are returned as cell indices, row * column count + column. Only the split cells
+	// are visited, the runs between them are in or out of the contour as a whole.
+	// The rows are scanned in parallel, each keeping its polys and the vertices it moves; both
+	// are then gathered in the order of the rows so the result is the one of a serial scan.
+	//----------------------------------------------------------------------------------------------
+	std::vector<int> LinearMesh::BuildPolyMesh(MeshGrid& grid, CellGrid const& cells, unsigned threadCount)
 	{
-		std::vector<MeshPoly*> polyFinal;
+		const int rowCount = cells.GetRowCount();
+		const int columnCount = cells.GetColumnCount();
+
+		struct RowScan
+		{
+			std::vector<int> Polys;
+			std::vector<std::pair<int, Vector2F>> Moves;
+		};
+		std::vector<RowScan> scans(rowCount);
+
 		// start parcours
-		for (int row = 0; row < paramsGeneration->RowCount - 1; row++)
+		Parallel::For(size_t(rowCount), threadCount, [&](size_t rowIndex)
 		{
+			const int row = int(rowIndex);
+			std::vector<int>& polyFinal = scans[row].Polys;
+			std::vector<std::pair<int, Vector2F>>& moves = scans[row].Moves;
 			bool isSelected = false;
 			bool isSelectedInversed = false;
+			int column = 0;
 
-			for (int column = 0; column < paramsGeneration->ColumnCount - 1; column++)
+			auto addRun = [&](int end)
 			{
+				if (isSelected || isSelectedInversed)
+				{
+					for (int runColumn = column; runColumn < end; runColumn++)
+					{
+						polyFinal.push_back(row * columnCount + runColumn);
+					}
+				}
+				column = end;
+			};
+
+			cells.VisitRow(row, [&](int splitColumn, unsigned char sides)
+			{
+				addRun(splitColumn);
 				bool isAddedNormal = false;
 				bool isAddedInversed = false;
 
 				// test Bot
 				// Focus on the bot to check if an intersection start the definition of the contour.
-				if (polys[row][column].SideSplit[2])
+				if (sides & SPLIT_BOTTOM)
 				{
 					isAddedNormal = true;
 					isSelected = !isSelected;
@@ -295,105 +456,111 @@ namespace mesh_generator
 				// test top
 				// Maybe the have detected the bottom intersection for out of the outline, 
 				// but the next poly i included because they don't continue to the top.
-				if (polys[row][column].SideSplit[0])
+				if (sides & SPLIT_TOP)
 				{
 					isAddedInversed = true;
 					isSelectedInversed = !isSelectedInversed;
 				}
 				isAddedInversed |= isSelectedInversed;
 
-				FixEdgeCaseThreeAndFiveVertice(polys, row, column, isSelected, isSelectedInversed);
+				FixEdgeCaseThreeAndFiveVertice(grid, cells, row, splitColumn, isSelected, isSelectedInversed, moves);
 
 				// Move vertex.
-				if (polys[row][column].SideSplit[2] && polys[row][column].SideSplit[0])
+				if ((sides & SPLIT_BOTTOM) && (sides & SPLIT_TOP))
 				{
-					if (isSelected) polys[row][column].Vertex[3]->Position = polys[row][column].BottomIntersection;
-					if (!isSelected ) polys[row][column].Vertex[2]->Position = polys[row][column].BottomIntersection;
+					const Vector2F bottomIntersection = cells.GetIntersection(row, splitColumn).Bottom;
+					if (isSelected) moves.emplace_back(grid.Index(row + 1, splitColumn), bottomIntersection);
+					if (!isSelected) moves.emplace_back(grid.Index(row + 1, splitColumn + 1), bottomIntersection);
 				}
 
 				// Add poly.
-				if (isAddedNormal && !polys[row][column].IsIncluded)
-				{
-					polys[row][column].IsIncluded = true;
-					polyFinal.push_back(&polys[row][column]);
-					continue;
-				}
-
-				if(isAddedInversed && !polys[row][column].IsIncluded)
+				if (isAddedNormal || isAddedInversed)
 				{
-					polys[row][column].IsIncluded = true;
-					polyFinal.push_back(&polys[row][column]);
+					polyFinal.push_back(row * columnCount + splitColumn);
 				}
+				column = splitColumn + 1;
+			});
+			addRun(columnCount);
+		});
+
+		// Two rows move the vertices between them, the lower one last.
+		size_t polyCount = 0;
+		for (auto const& scan : scans)
+		{
+			polyCount += scan.Polys.size();
+			for (auto const& move : scan.Moves)
+			{
+				grid.Positions[move.first] = move.second;
 			}
 		}
-
-		for (int column = paramsGeneration->ColumnCount - 2; column >= 0 ; column--)
+		std::vector<int> polyFinal;
+		polyFinal.reserve(polyCount);
+		for (auto& scan : scans)
 		{
-			bool isSelected = false;
-			bool isSelectedInversed = false;
+			polyFinal.insert(polyFinal.end(), scan.Polys.begin(), scan.Polys.end());
+			std::vector<int>().swap(scan.Polys);
+		}
 
-			for (int row = 0; row < paramsGeneration->RowCount - 1; row++)
+		// Same scan by column, the selection of each column being kept while going down the rows.
+		// Only the left sides toggle it, a vertex is only moved from the poly on its left: the
+		// bands of columns move distinct vertices and run in parallel.
+		const int bandTarget = int(Parallel::ThreadCount(threadCount)) * 4;
+		const int bandWidth = std::max(1, (columnCount + bandTarget - 1) / bandTarget);
+		const int bandCount = (columnCount + bandWidth - 1) / bandWidth;
+		std::vector<unsigned char> columnSelected(columnCount, 0);
+		Parallel::For(size_t(bandCount), threadCount, [&](size_t band)
+		{
+			const int firstColumn = int(band) * bandWidth;
+			const int endColumn = std::min(columnCount, firstColumn + bandWidth);
+			for (int row = 0; row < rowCount; row++)
 			{
-				bool isAddedNormal = false;
-				bool isAddedInversed = false;
-
-				// test Bot
-				// Focus on the bot to check if an intersection start the definition of the contour.
-				if (polys[row][column].SideSplit[3])
-				{
-					isAddedNormal = true;
-					isSelected = !isSelected;
-				}
-				isAddedNormal |= isSelected;
-
-				// test top
-				// Maybe the have detected the bottom intersection for out of the outline, 
-				// but the next poly i included because they don't continue to the top.
-				if (polys[row][column].SideSplit[1])
+				cells.VisitRow(row, firstColumn, endColumn, [&](int column, unsigned char sides)
 				{
-					isAddedInversed = true;
-					isSelectedInversed = !isSelectedInversed;
-				}
-				isAddedInversed |= isSelectedInversed;
+					if (!(sides & SPLIT_LEFT)) return;
+					columnSelected[column] ^= 1;
 
-				// Move vertex.
-				if (polys[row][column].SideSplit[1] && polys[row][column].SideSplit[3])
-				{
-					if (isSelected) polys[row][column].Vertex[1]->Position = polys[row][column].RigthIntersection;
-					if (!isSelected) polys[row][column].Vertex[2]->Position = polys[row][column].RigthIntersection;
-				}
+					// Move vertex.
+					if (sides & SPLIT_RIGHT)
+					{
+						const Vector2F rightIntersection = cells.GetIntersection(row, column).Right;
+						if (columnSelected[column]) grid.Position(row, column + 1) = rightIntersection;
+						if (!columnSelected[column]) grid.Position(row + 1, column + 1) = rightIntersection;
+					}
+				});
 			}
-		}
+		});
 		return polyFinal;
 	}
 
 	//----------------------------------------------------------------------------------------------
-	DataMesh LinearMesh::BuildDataMesh(MeshVertex** grid, std::vector<MeshPoly*> polys, GlobalParameters* paramsGeneration)
+	DataMesh LinearMesh::BuildDataMesh(MeshGrid const& grid, std::vector<int> const& polys, GlobalParameters* paramsGeneration)
 	{
 		DataMesh dataMesh = DataMesh(paramsGeneration->GetName());
-		if (grid == nullptr) return dataMesh;
+		if (grid.Positions.empty()) return dataMesh;
 
-		// Add vertices
-		std::vector<Vector2F> vertice;
-		int currentVertexIndex = 0;
-		for (int row = 0; row < paramsGeneration->RowCount; row++)
+		// Every vertex of the grid is kept, in the order of the grid.
+		const int columnCount = grid.ColumnCount - 1;
+		std::vector<int> facesCount(polys.size(), 4);
+		std::vector<int> facesIndices(polys.size() * 4);
+
+		// Each block of polys writes its own part of the indices.
+		const size_t blockSize = 1 << 16;
+		Parallel::For((polys.size() + blockSize - 1) / blockSize, paramsGeneration->GetThreadCount(), [&](size_t block)
 		{
-			for (int column = 0; column < paramsGeneration->ColumnCount; column++)
+			const size_t end = std::min(polys.size(), (block + 1) * blockSize);
+			for (size_t i = block * blockSize; i < end; i++)
 			{
-				if (&grid[row][column] == nullptr) continue;
-
-				grid[row][column].Index = currentVertexIndex;
-				vertice.push_back(grid[row][column].Position);
-				currentVertexIndex++;
+				const int row = polys[i] / columnCount;
+				const int column = polys[i] % columnCount;
+				// order: topLeft, topRight, bottomRight, bottomLeft
+				int* face = &facesIndices[i * 4];
+				face[0] = grid.Index(row, column);
+				face[1] = grid.Index(row, column + 1);
+				face[2] = grid.Index(row + 1, column + 1);
+				face[3] = grid.Index(row + 1, column);
 			}
-		}
-		dataMesh.SetVertices(vertice);
-
-		// Add faces
-		for (auto poly : polys)
-		{
-			dataMesh.AddFace(poly->GetVertexIndexes());
-		}
+		});
+		dataMesh.SetValues(grid.Positions, facesCount, facesIndices);
 
 		return dataMesh;
 	}
@@ -410,49 +577,53 @@ namespace mesh_generator
 	}
 
 	//----------------------------------------------------------------------------------------
-	void LinearMesh::FixEdgeCaseThreeAndFiveVertice(MeshPoly ** polys, int row, int column, bool isSelected, bool isSelectedInversed)
+	void LinearMesh::FixEdgeCaseThreeAndFiveVertice(MeshGrid const& grid, CellGrid const& cells, int row, int column, bool isSelected, bool isSelectedInversed, std::vector<std::pair<int, Vector2F>>& moves)
 	{
+		const unsigned char sides = cells.GetSplit(row, column);
+		const CellIntersection here = cells.GetIntersection(row, column);
+		const Vector2F leftRight = cells.GetIntersection(row, column - 1).Right;
+		const Vector2F topBottom = cells.GetIntersection(row - 1, column).Bottom;
 
-		if (polys[row][column].SideSplit[2] && polys[row][column].SideSplit[1] && isSelected)
+		if ((sides & SPLIT_BOTTOM) && (sides & SPLIT_RIGHT) && isSelected)
 		{
-			polys[row][column].Vertex[1]->Position = polys[row][column].RigthIntersection;
-			polys[row][column].Vertex[3]->Position = polys[row][column].BottomIntersection;
-			polys[row][column].Vertex[0]->Position = GetCenterSegment(polys[row][column].RigthIntersection, polys[row][column].BottomIntersection);
+			moves.emplace_back(grid.Index(row, column + 1), here.Right);
+			moves.emplace_back(grid.Index(row + 1, column), here.Bottom);
+			moves.emplace_back(grid.Index(row, column), GetCenterSegment(here.Right, here.Bottom));
 			return;
 
 		}
-		if (polys[row][column].SideSplit[2] && polys[row][column].SideSplit[3] && !isSelected)
+		if ((sides & SPLIT_BOTTOM) && (sides & SPLIT_LEFT) && !isSelected)
 		{
-			polys[row][column].Vertex[0]->Position = polys[row][column-1].RigthIntersection;
-			polys[row][column].Vertex[2]->Position = polys[row][column].BottomIntersection;
-			polys[row][column].Vertex[1]->Position = GetCenterSegment(polys[row][column-1].RigthIntersection, polys[row][column].BottomIntersection);
+			moves.emplace_back(grid.Index(row, column), leftRight);
+			moves.emplace_back(grid.Index(row + 1, column + 1), here.Bottom);
+			moves.emplace_back(grid.Index(row, column + 1), GetCenterSegment(leftRight, here.Bottom));
 
 		}
-		if (polys[row][column].SideSplit[0] && polys[row][column].SideSplit[1] && isSelectedInversed)
+		if ((sides & SPLIT_TOP) && (sides & SPLIT_RIGHT) && isSelectedInversed)
 		{
-			polys[row][column].Vertex[2]->Position = polys[row][column].RigthIntersection;
-			polys[row][column].Vertex[0]->Position = polys[row-1][column].BottomIntersection;
-			polys[row][column].Vertex[3]->Position = GetCenterSegment(polys[row][column].RigthIntersection, polys[row-1][column].BottomIntersection);
+			moves.emplace_back(grid.Index(row + 1, column + 1), here.Right);
+			moves.emplace_back(grid.Index(row, column), topBottom);
+			moves.emplace_back(grid.Index(row + 1, column), GetCenterSegment(here.Right, topBottom));
 
 		}
-		if (polys[row][column].SideSplit[0] && polys[row][column].SideSplit[3] && !isSelectedInversed)
+		if ((sides & SPLIT_TOP) && (sides & SPLIT_LEFT) && !isSelectedInversed)
 		{
-			polys[row][column].Vertex[1]->Position = polys[row-1][column].BottomIntersection;
-			polys[row][column].Vertex[3]->Position = polys[row][column-1].RigthIntersection;
-			polys[row][column].Vertex[2]->Position = GetCenterSegment(polys[row-1][column].BottomIntersection, polys[row][column-1].RigthIntersection);
+			moves.emplace_back(grid.Index(row, column + 1), topBottom);
+			moves.emplace_back(grid.Index(row + 1, column), leftRight);
+			moves.emplace_back(grid.Index(row + 1, column + 1), GetCenterSegment(topBottom, leftRight));
 		}
 
-		if (polys[row][column].SideSplit[2] && polys[row][column].SideSplit[3] && isSelected)
-			polys[row][column].Vertex[3]->Position = GetCenterSegment(polys[row][column].BottomIntersection, polys[row][column-1].RigthIntersection);
+		if ((sides & SPLIT_BOTTOM) && (sides & SPLIT_LEFT) && isSelected)
+			moves.emplace_back(grid.Index(row + 1, column), GetCenterSegment(here.Bottom, leftRight));
 
-		if (polys[row][column].SideSplit[2] && polys[row][column].SideSplit[1] && !isSelected)
-			polys[row][column].Vertex[2]->Position = GetCenterSegment(polys[row][column].BottomIntersection, polys[row][column].RigthIntersection);
+		if ((sides & SPLIT_BOTTOM) && (sides & SPLIT_RIGHT) && !isSelected)
+			moves.emplace_back(grid.Index(row + 1, column + 1), GetCenterSegment(here.Bottom, here.Right));
 
-		if (polys[row][column].SideSplit[0] && polys[row][column].SideSplit[3] && isSelectedInversed)
-			polys[row][column].Vertex[0]->Position = GetCenterSegment(polys[row-1][column].BottomIntersection, polys[row][column - 1].RigthIntersection);
+		if ((sides & SPLIT_TOP) && (sides & SPLIT_LEFT) && isSelectedInversed)
+			moves.emplace_back(grid.Index(row, column), GetCenterSegment(topBottom, leftRight));
 
-		if (polys[row][column].SideSplit[0] && polys[row][column].SideSplit[1] && !isSelectedInversed)
-			polys[row][column].Vertex[1]->Position = GetCenterSegment(polys[row-1][column].BottomIntersection, polys[row][column].RigthIntersection);
+		if ((sides & SPLIT_TOP) && (sides & SPLIT_RIGHT) && !isSelectedInversed)
+			moves.emplace_back(grid.Index(row, column + 1), GetCenterSegment(topBottom, here.Right));
 
 	}
 
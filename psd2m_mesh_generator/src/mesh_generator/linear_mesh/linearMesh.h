@@ -17,9 +17,12 @@
 #ifndef LINEAR_MESH_H
 #define LINEAR_MESH_H
 
+#include <algorithm>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 #include "util/math_2D.h"
+#include "util/parallel.h"
 #include "bezierCurve.h"
 #include "boundingBox.h"
 #include "../dataMesh.h"
@@ -32,27 +35,116 @@ namespace mesh_generator
 	{
 		int LinearHeightPoly = 10;
 		float GridOrientation = 0.0f;
+		bool GridAutoOrientation = false; // Grid along the smallest box around the paths, GridOrientation ignored.
+		unsigned ThreadCount = 0; // Threads building the mesh, 0 for one per hardware thread, 1 to build serially.
 	};
 
 	//----------------------------------------------------------------------------------------------
-	struct MeshVertex
+	// Vertices of the grid in a single array, row after row.
+	struct MeshGrid
 	{
-		// Use to keep the position in the array of vertices.
-		int Index = -1;
-		Vector2F Position;
+		int RowCount = 0;
+		int ColumnCount = 0;
+		std::vector<Vector2F> Positions;
+
+		int Index(int row, int column) const { return row * this->ColumnCount + column; }
+		Vector2F& Position(int row, int column) { return this->Positions[Index(row, column)]; }
+	};
+
+	//----------------------------------------------------------------------------------------------
+	// Sides of a cell crossed by a contour.
+	enum SIDE_SPLIT : unsigned char
+	{
+		SPLIT_TOP = 1 << 0,
+		SPLIT_RIGHT = 1 << 1,
+		SPLIT_BOTTOM = 1 << 2,
+		SPLIT_LEFT = 1 << 3
+	};
+
+	//----------------------------------------------------------------------------------------------
+	// A contour crossing a line of the grid, on the side of the cell (Row, Column) and of the cell
+	// below it or on its right.
+	struct GridCrossing
+	{
+		int Row = 0;
+		int Column = 0;
+		bool AcrossRows = false; // The bottom side, else the right side.
+		Vector2F Intersection;
 	};
 
 	//----------------------------------------------------------------------------------------------
-	struct MeshPoly
+	// Where a contour crosses the right and the bottom side of a cell.
+	struct CellIntersection
 	{
-		MeshVertex* Vertex[4]{}; // order: topLeft, topRight, bottomRight, bottomLeft
-		Vector2F RigthIntersection = Vector2F(-1.f, -1.f);
-		Vector2F BottomIntersection = Vector2F(-1.f, -1.f);
-		int IndexToRemove = -1;
-		bool IsIncluded = false;
-		bool SideSplit[4] = { false, false, false, false }; // top, right, bottom, left;
-
-		std::vector<int> GetVertexIndexes();
+		Vector2F Right = Vector2F(-1.f, -1.f);
+		Vector2F Bottom = Vector2F(-1.f, -1.f);
+	};
+
+	//----------------------------------------------------------------------------------------------
+	// Split sides of the cells between the grid vertices, the cell (row, column) having the vertex
+	// (row, column) as top left corner. Dense grids keep a byte per cell. In narrow band the rows
+	// only keep the cells crossed by a contour, sorted by column once Seal is called, for the grids
+	// too fine for a byte per cell. Intersections are only kept for the crossed cells.
+	class CellGrid
+	{
+	public:
+		CellGrid(int rowCount, int columnCount, bool narrowBand);
+
+		int GetRowCount() const { return this->RowCount; }
+		int GetColumnCount() const { return this->ColumnCount; }
+		bool IsNarrowBand() const { return this->NarrowBand; }
+		bool Contains(int row, int column) const { return row >= 0 && row < this->RowCount && column >= 0 && column < this->ColumnCount; }
+
+		unsigned char GetSplit(int row, int column) const;
+		void AddSplit(int row, int column, unsigned char sides);
+		void RemoveSplit(int row, int column, unsigned char sides);
+		CellIntersection GetIntersection(int row, int column) const;
+		void SetRightIntersection(int row, int column, Vector2F const& point);
+		void SetBottomIntersection(int row, int column, Vector2F const& point);
+
+		// Ends the marking, the narrow band rows are sorted and their duplicates merged.
+		void Seal();
+
+		// visit(column, sides) for the split cells of a row from left to right, reading the sides
+		// when the cell is reached.
+		template <typename Visit>
+		void VisitRow(int row, Visit visit) const
+		{
+			VisitRow(row, 0, this->ColumnCount, visit);
+		}
+
+		// Same for the columns from firstColumn to endColumn excluded.
+		template <typename Visit>
+		void VisitRow(int row, int firstColumn, int endColumn, Visit visit) const
+		{
+			if (this->NarrowBand)
+			{
+				auto const& cells = this->BandRows[row];
+				auto it = std::lower_bound(cells.begin(), cells.end(), firstColumn, [](std::pair<int, unsigned char> const& cell, int value) { return cell.first < value; });
+				for (; it != cells.end() && it->first < endColumn; ++it)
+				{
+					if (it->second != 0) visit(it->first, it->second);
+				}
+				return;
+			}
+			const unsigned char* splits = &this->Splits[size_t(row) * this->ColumnCount];
+			for (int column = firstColumn; column < endColumn; column++)
+			{
+				if (splits[column] != 0) visit(column, splits[column]);
+			}
+		}
+
+	private:
+		int RowCount = 0;
+		int ColumnCount = 0;
+		bool NarrowBand = false;
+		std::vector<unsigned char> Splits;
+		std::vector<std::vector<std::pair<int, unsigned char>>> BandRows;
+		std::unordered_map<long long, CellIntersection> Intersections;
+
+		long long Key(int row, int column) const { return (long long)row * this->ColumnCount + column; }
+		unsigned char* FindBand(int row, int column);
+		const unsigned char* FindBand(int row, int column) const;
 	};
 
 	struct GlobalParameters
@@ -67,6 +159,7 @@ namespace mesh_generator
 		GlobalParameters(std::string name, LinearParameters const& params) : Name(std::move(name)), Parameters(params){}
 
 		std::string GetName() const { return this->Name; }
+		unsigned GetThreadCount() const { return this->Parameters.ThreadCount; }
 		float GetPrecision() const
 		{
 			return (float(this->Parameters.LinearHeightPoly));
@@ -81,17 +174,21 @@ namespace mesh_generator
 	class LinearMesh
 	{
 	public:
-		static DataMesh GenerateMesh(std::string const& name, LinearParameters const& params, boundingBox& bounds, std::vector<BezierCurve*> curves);
+		static DataMesh GenerateMesh(std::string const& name, LinearParameters const& params, boundingBox& bounds, std::vector<BezierCurve> const& curves);
 
 	private:
-		static MeshVertex** GenerateGrid(boundingBox & bounds, GlobalParameters* paramsGeneration);
-		static std::vector<MeshPoly*> FilterGrid(MeshVertex ** initialGrid, const std::vector<BezierCurve*>& curves, boundingBox & bounds, GlobalParameters* paramsGeneration);
-		static void IdentificationContourPoly(MeshPoly ** polys, BezierCurve const & curve, boundingBox & bounds, GlobalParameters* paramsGeneration);
-		static void CleanAloneSplit(MeshPoly ** polys, GlobalParameters* paramsGeneration);
-		static std::vector<MeshPoly*> BuildPolyMesh(MeshPoly ** polys, GlobalParameters* paramsGeneration);
-		static DataMesh BuildDataMesh(MeshVertex** grid, std::vector<MeshPoly*> polys, GlobalParameters* paramsGeneration);
+		// Above this count of cells, the cell grid switches to narrow band.
+		static const long long NARROW_BAND_CELLS = 1ll << 22;
+
+		static MeshGrid GenerateGrid(boundingBox & bounds, GlobalParameters* paramsGeneration);
+		static std::vector<int> FilterGrid(MeshGrid& grid, const std::vector<BezierCurve>& curves, boundingBox & bounds, GlobalParameters* paramsGeneration);
+		static void IdentificationContourPoly(std::vector<GridCrossing>& crossings, BezierCurve const & curve, boundingBox & bounds, GlobalParameters* paramsGeneration);
+		static void MarkCrossings(CellGrid& cells, std::vector<GridCrossing> const& crossings);
+		static void CleanAloneSplit(CellGrid& cells);
+		static std::vector<int> BuildPolyMesh(MeshGrid& grid, CellGrid const& cells, unsigned threadCount);
+		static DataMesh BuildDataMesh(MeshGrid const& grid, std::vector<int> const& polys, GlobalParameters* paramsGeneration);
 		static Vector2F GetCenterSegment(Vector2F pos1, Vector2F pos2);
-		static void FixEdgeCaseThreeAndFiveVertice(MeshPoly ** polys, int row, int column, bool isSelected, bool isSelectedInversed);
+		static void FixEdgeCaseThreeAndFiveVertice(MeshGrid const& grid, CellGrid const& cells, int row, int column, bool isSelected, bool isSelectedInversed, std::vector<std::pair<int, Vector2F>>& moves);
 
 	};
 }
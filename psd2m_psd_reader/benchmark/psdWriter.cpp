@@ -0,0 +1,402 @@
+//----------------------------------------------------------------------------------------------
+// ===============================================
+//  Copyright (C) 2026, E.D. Films.
+//  All Rights Reserved.
+// ===============================================
+//  Unauthorized copying of this file, via any medium is strictly prohibited
+//  Proprietary and confidential
+//
+//  @file psdWriter.cpp
+//  @author Michaelson Britt
+//  @date 16-10-2026
+//
+//  @section DESCRIPTION
+//
+//----------------------------------------------------------------------------------------------
+
+#include "psdWriter.h"
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <string>
+#include <zlib.h>
+
+namespace psd_benchmark
+{
+	//----------------------------------------------------------------------------------------------
+	// Appends big-endian values to a buffer.
+	struct BigEndianWriter
+	{
+		std::vector<unsigned char> Bytes;
+
+		void Write(unsigned long long value, int size)
+		{
+			for (int shift = (size - 1) * 8; shift >= 0; shift -= 8)
+			{
+				this->Bytes.push_back(static_cast<unsigned char>(value >> shift));
+			}
+		}
+
+		void WriteZeros(size_t count)
+		{
+			this->Bytes.insert(this->Bytes.end(), count, 0);
+		}
+
+		// 4 bytes in a PSD, 8 in a PSB.
+		void WriteLength(unsigned long long value, bool large)
+		{
+			Write(value, large ? 8 : 4);
+		}
+
+		void WriteKey(const char* key)
+		{
+			this->Bytes.insert(this->Bytes.end(), key, key + 4);
+		}
+
+		void WriteBytes(std::vector<unsigned char> const& data)
+		{
+			this->Bytes.insert(this->Bytes.end(), data.begin(), data.end());
+		}
+
+		void PadTo(size_t multiple)
+		{
+			while (this->Bytes.size() % multiple) this->Bytes.push_back(0);
+		}
+
+		// Additional layer information, the keys holding pixels have an 8 bytes length in a PSB.
+		void WriteTaggedBlock(const char* key, std::vector<unsigned char> data, bool large)
+		{
+			if (data.size() % 2) data.push_back(0);
+			const bool longLength = large && (std::strcmp(key, "Lr16") == 0 || std::strcmp(key, "Lr32") == 0);
+			WriteKey("8BIM");
+			WriteKey(key);
+			WriteLength(data.size(), longLength);
+			WriteBytes(data);
+		}
+	};
+
+#pragma region WRITER
+
+	//----------------------------------------------------------------------------------------
+	std::vector<unsigned char> PsdWriter::Write(SyntheticParameters const& parameters, SectionSizes& sizes)
+	{
+		const bool large = parameters.LargeDocument;
+		BigEndianWriter file;
+
+		// HEADER, RGB
+		file.WriteKey("8BPS");
+		file.Write(large ? 2 : 1, 2);
+		file.Write(0, 6);
+		file.Write(3, 2);
+		file.Write(parameters.Height, 4);
+		file.Write(parameters.Width, 4);
+		file.Write(parameters.Depth, 2);
+		file.Write(3, 2);
+		sizes.Header = file.Bytes.size();
+
+		// COLOR MODE
+		file.Write(0, 4);
+		sizes.ColorMode = 4;
+
+		// IMAGE RESOURCES, resolution info only
+		BigEndianWriter resources;
+		resources.WriteKey("8BIM");
+		resources.Write(1005, 2);
+		resources.Write(0, 2);
+		resources.Write(16, 4);
+		resources.Write(72 << 16, 4);
+		resources.Write(1, 2);
+		resources.Write(1, 2);
+		resources.Write(72 << 16, 4);
+		resources.Write(1, 2);
+		resources.Write(1, 2);
+		file.Write(resources.Bytes.size(), 4);
+		file.WriteBytes(resources.Bytes);
+		sizes.ImageResources = 4 + resources.Bytes.size();
+
+		// LAYER RECORDS, then the channels in the same order
+		BigEndianWriter records;
+		BigEndianWriter channels;
+		records.Write(static_cast<unsigned long long>(-static_cast<long long>(parameters.LayerCount)), 2);
+		for (unsigned layer = 0; layer < parameters.LayerCount; ++layer)
+		{
+			records.Write(0, 4);
+			records.Write(0, 4);
+			records.Write(parameters.Height, 4);
+			records.Write(parameters.Width, 4);
+			records.Write(4, 2);
+			for (unsigned c = 0; c < 4; ++c)
+			{
+				const short channelId = static_cast<short>(c) - 1;
+				const std::vector<unsigned char> channel = EncodeChannel(parameters, LayerChannel(parameters, layer, channelId), true);
+				records.Write(static_cast<unsigned short>(channelId), 2);
+				records.WriteLength(channel.size(), large);
+				channels.WriteBytes(channel);
+			}
+			records.WriteKey("8BIM");
+			records.WriteKey("norm");
+			records.Write(255, 1); // Opacity
+			records.Write(0, 3); // Clipping, flags, filler
+
+			BigEndianWriter extra;
+			extra.Write(0, 4); // Layer mask
+			extra.Write(8, 4); // Blending ranges, gray only
+			extra.Write(0x0000FFFF, 4);
+			extra.Write(0x0000FFFF, 4);
+			const std::string name = "Layer " + std::to_string(layer);
+			const size_t nameStart = extra.Bytes.size();
+			extra.Write(name.size(), 1);
+			extra.Bytes.insert(extra.Bytes.end(), name.begin(), name.end());
+			while ((extra.Bytes.size() - nameStart) % 4) extra.Bytes.push_back(0);
+			if (parameters.MaskPoints > 0)
+			{
+				BigEndianWriter mask;
+				mask.Write(3, 4); // Version
+				mask.Write(0, 4); // Flags
+				mask.WriteBytes(PathRecords(parameters.MaskPoints, layer));
+				extra.WriteTaggedBlock("vmsk", mask.Bytes, large);
+			}
+			records.Write(extra.Bytes.size(), 4);
+			records.WriteBytes(extra.Bytes);
+		}
+
+		BigEndianWriter layerInfo;
+		layerInfo.WriteBytes(records.Bytes);
+		layerInfo.WriteBytes(channels.Bytes);
+		layerInfo.PadTo(2);
+
+		// The 16 and 32 bits layers are stored in an additional layer information block.
+		BigEndianWriter layerAndMask;
+		if (parameters.Depth == 8)
+		{
+			layerAndMask.WriteLength(layerInfo.Bytes.size(), large);
+			layerAndMask.WriteBytes(layerInfo.Bytes);
+			layerAndMask.Write(0, 4); // Global layer mask
+		}
+		else
+		{
+			layerAndMask.WriteLength(0, large);
+			layerAndMask.Write(0, 4);
+			layerAndMask.WriteTaggedBlock(parameters.Depth == 16 ? "Lr16" : "Lr32", layerInfo.Bytes, large);
+		}
+		file.WriteLength(layerAndMask.Bytes.size(), large);
+		file.WriteBytes(layerAndMask.Bytes);
+		sizes.LayerPixels = channels.Bytes.size();
+		sizes.LayerStructure = (large ? 8 : 4) + layerAndMask.Bytes.size() - sizes.LayerPixels;
+
+		// IMAGE DATA, planar with one compression value. RLE rows counts come first for every plane.
+		const size_t imageStart = file.Bytes.size();
+		file.Write(parameters.Compression, 2);
+		if (parameters.Compression == RLE)
+		{
+			std::vector<std::vector<unsigned char>> planes;
+			for (unsigned c = 0; c < 3; ++c)
+			{
+				planes.push_back(EncodeRle(parameters, CompositePlane(parameters, c)));
+			}
+			const size_t countsSize = size_t(parameters.Height) * (large ? 4 : 2);
+			for (auto const& plane : planes) file.Bytes.insert(file.Bytes.end(), plane.begin(), plane.begin() + countsSize);
+			for (auto const& plane : planes) file.Bytes.insert(file.Bytes.end(), plane.begin() + countsSize, plane.end());
+		}
+		else
+		{
+			std::vector<unsigned char> planes;
+			for (unsigned c = 0; c < 3; ++c)
+			{
+				const std::vector<unsigned char> plane = CompositePlane(parameters, c);
+				planes.insert(planes.end(), plane.begin(), plane.end());
+			}
+			SyntheticParameters merged = parameters;
+			merged.Height *= 3;
+			file.WriteBytes(EncodeChannel(merged, planes, false));
+		}
+		sizes.ImageData = file.Bytes.size() - imageStart;
+
+		return file.Bytes;
+	}
+
+	//----------------------------------------------------------------------------------------
+	std::vector<unsigned char> PsdWriter::LayerChannel(SyntheticParameters const& parameters, unsigned layer, short channelId)
+	{
+		return MakePixels(parameters, parameters.Seed + layer * 4 + (channelId + 1));
+	}
+
+	//----------------------------------------------------------------------------------------
+	std::vector<unsigned char> PsdWriter::CompositePlane(SyntheticParameters const& parameters, unsigned plane)
+	{
+		return MakePixels(parameters, parameters.Seed + 1000 + plane);
+	}
+
+	//----------------------------------------------------------------------------------------
+	std::vector<unsigned char> PsdWriter::MakePixels(SyntheticParameters const& parameters, unsigned seed)
+	{
+		// Runs of a constant value broken by noise, one value in five starts a new run.
+		std::mt19937 random(seed);
+		const size_t sampleBytes = parameters.Depth / 8;
+		const size_t count = size_t(parameters.Width) * parameters.Height;
+		std::vector<unsigned char> pixels(count * sampleBytes);
+		unsigned value = random() & 0xFF;
+		for (size_t i = 0; i < count; ++i)
+		{
+			if (random() % 5 == 0) value = random() & 0xFF;
+			unsigned char* sample = &pixels[i * sampleBytes];
+			if (parameters.Depth == 8)
+			{
+				sample[0] = static_cast<unsigned char>(value);
+			}
+			else if (parameters.Depth == 16)
+			{
+				sample[0] = sample[1] = static_cast<unsigned char>(value);
+			}
+			else
+			{
+				const float real = value / 255.0f;
+				unsigned int bits;
+				std::memcpy(&bits, &real, 4);
+				for (int b = 0; b < 4; ++b) sample[b] = static_cast<unsigned char>(bits >> (24 - b * 8));
+			}
+		}
+		return pixels;
+	}
+
+	//----------------------------------------------------------------------------------------
+	std::vector<unsigned char> PsdWriter::EncodeChannel(SyntheticParameters const& parameters, std::vector<unsigned char> const& pixels, bool withCompression)
+	{
+		BigEndianWriter channel;
+		if (withCompression) channel.Write(parameters.Compression, 2);
+		switch (parameters.Compression)
+		{
+		case RLE: channel.WriteBytes(EncodeRle(parameters, pixels)); break;
+		case ZIP: channel.WriteBytes(Deflate(pixels)); break;
+		case ZIP_PREDICTION: channel.WriteBytes(Deflate(Predict(parameters, pixels))); break;
+		default: channel.WriteBytes(pixels); break;
+		}
+		return channel.Bytes;
+	}
+
+	//----------------------------------------------------------------------------------------
+	std::vector<unsigned char> PsdWriter::EncodeRle(SyntheticParameters const& parameters, std::vector<unsigned char> const& pixels)
+	{
+		// PackBits per row, the row sizes first.
+		const size_t rowBytes = size_t(parameters.Width) * (parameters.Depth / 8);
+		BigEndianWriter counts;
+		std::vector<unsigned char> rows;
+		for (size_t row = 0; row < parameters.Height; ++row)
+		{
+			const unsigned char* source = &pixels[row * rowBytes];
+			const size_t start = rows.size();
+			size_t i = 0;
+			while (i < rowBytes)
+			{
+				size_t run = 1;
+				while (i + run < rowBytes && run < 128 && source[i + run] == source[i]) ++run;
+				if (run > 1)
+				{
+					rows.push_back(static_cast<unsigned char>(257 - run));
+					rows.push_back(source[i]);
+					i += run;
+					continue;
+				}
+
+				size_t literal = 1;
+				while (i + literal < rowBytes && literal < 128 && !(i + literal + 1 < rowBytes && source[i + literal] == source[i + literal + 1])) ++literal;
+				rows.push_back(static_cast<unsigned char>(literal - 1));
+				rows.insert(rows.end(), source + i, source + i + literal);
+				i += literal;
+			}
+			counts.Write(rows.size() - start, parameters.LargeDocument ? 4 : 2);
+		}
+		counts.WriteBytes(rows);
+		return counts.Bytes;
+	}
+
+	//----------------------------------------------------------------------------------------
+	std::vector<unsigned char> PsdWriter::Predict(SyntheticParameters const& parameters, std::vector<unsigned char> const& pixels)
+	{
+		// Differences along the rows, on 16-bit samples at 16 bits and on the byte planes of the row at 32.
+		const size_t cols = parameters.Width;
+		const size_t rowBytes = cols * (parameters.Depth / 8);
+		std::vector<unsigned char> predicted(pixels.size());
+		for (size_t row = 0; row * rowBytes < pixels.size(); ++row)
+		{
+			const unsigned char* source = &pixels[row * rowBytes];
+			unsigned char* destination = &predicted[row * rowBytes];
+			if (parameters.Depth == 16)
+			{
+				unsigned previous = 0;
+				for (size_t c = 0; c < cols; ++c)
+				{
+					const unsigned value = (source[c * 2] << 8) | source[c * 2 + 1];
+					const unsigned delta = (value - previous) & 0xFFFF;
+					destination[c * 2] = static_cast<unsigned char>(delta >> 8);
+					destination[c * 2 + 1] = static_cast<unsigned char>(delta);
+					previous = value;
+				}
+				continue;
+			}
+
+			std::vector<unsigned char> planar(source, source + rowBytes);
+			if (parameters.Depth == 32)
+			{
+				for (size_t c = 0; c < cols; ++c)
+				{
+					for (size_t b = 0; b < 4; ++b) planar[b * cols + c] = source[c * 4 + b];
+				}
+			}
+			unsigned char previous = 0;
+			for (size_t i = 0; i < rowBytes; ++i)
+			{
+				destination[i] = static_cast<unsigned char>(planar[i] - previous);
+				previous = planar[i];
+			}
+		}
+		return predicted;
+	}
+
+	//----------------------------------------------------------------------------------------
+	std::vector<unsigned char> PsdWriter::Deflate(std::vector<unsigned char> const& data)
+	{
+		uLongf size = compressBound(static_cast<uLong>(data.size()));
+		std::vector<unsigned char> compressed(size);
+		if (compress2(compressed.data(), &size, data.data(), static_cast<uLong>(data.size()), Z_DEFAULT_COMPRESSION) != Z_OK) return {};
+		compressed.resize(size);
+		return compressed;
+	}
+
+	//----------------------------------------------------------------------------------------
+	std::vector<unsigned char> PsdWriter::PathRecords(unsigned points, unsigned layerIndex)
+	{
+		// One closed star shaped path, each knot with its own tangents. Coordinates are fractions
+		// of the canvas, 8.24 fixed point, vertical first.
+		BigEndianWriter path;
+		auto point = [&path](double x, double y)
+		{
+			path.Write(static_cast<unsigned int>(static_cast<int>(std::lround(y * (1 << 24)))), 4);
+			path.Write(static_cast<unsigned int>(static_cast<int>(std::lround(x * (1 << 24)))), 4);
+		};
+
+		path.Write(6, 2); // Fill rule
+		path.WriteZeros(24);
+		path.Write(0, 2); // Closed subpath length
+		path.Write(points, 2);
+		path.WriteZeros(22);
+
+		const double pi = 3.14159265358979323846;
+		const double turn = layerIndex * 0.1;
+		for (unsigned i = 0; i < points; ++i)
+		{
+			const double angle = turn + 2 * pi * i / points;
+			const double radius = (i % 2) ? 0.3 : 0.45;
+			const double x = 0.5 + radius * std::cos(angle);
+			const double y = 0.5 + radius * std::sin(angle);
+			const double tangent = pi / points * radius;
+			path.Write(1, 2); // Closed subpath knot, linked
+			point(x + tangent * std::sin(angle), y - tangent * std::cos(angle));
+			point(x, y);
+			point(x - tangent * std::sin(angle), y + tangent * std::cos(angle));
+		}
+		return path.Bytes;
+	}
+
+#pragma endregion
+}
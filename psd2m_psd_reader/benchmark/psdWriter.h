@@ -0,0 +1,90 @@
+//----------------------------------------------------------------------------------------------
+// ===============================================
+//  Copyright (C) 2026, E.D. Films.
+//  All Rights Reserved.
+// ===============================================
+//  Unauthorized copying of this file, via any medium is strictly prohibited
+//  Proprietary and confidential
+//
+//  @file psdWriter.h
+//  @author Michaelson Britt
+//  @date 16-10-2026
+//
+//  @section DESCRIPTION
+//  Synthetic RGB documents for the reader benchmark, written in memory.
+//
+//----------------------------------------------------------------------------------------------
+
+#ifndef PSDWRITER_H
+#define PSDWRITER_H
+
+#include <vector>
+
+namespace psd_benchmark
+{
+#pragma region PARAMETERS
+
+	//----------------------------------------------------------------------------------------------
+	// Same values as LayerData::ChannelCompression.
+	enum COMPRESSION
+	{
+		RAW = 0,
+		RLE = 1,
+		ZIP = 2,
+		ZIP_PREDICTION = 3
+	};
+
+	//----------------------------------------------------------------------------------------------
+	struct SyntheticParameters
+	{
+		unsigned LayerCount = 16;
+		unsigned Width = 1024;
+		unsigned Height = 1024;
+		unsigned short Depth = 8; // 8, 16 or 32 bits per channel.
+		COMPRESSION Compression = RLE; // Layers and merged image.
+		unsigned MaskPoints = 0; // Knots of the vector mask of each layer, 0 for none.
+		bool LargeDocument = false; // PSB instead of PSD.
+		unsigned Seed = 1;
+	};
+
+	//----------------------------------------------------------------------------------------------
+	// Bytes of each part of a written document, matching SectionTimings.
+	struct SectionSizes
+	{
+		unsigned long long Header = 0;
+		unsigned long long ColorMode = 0;
+		unsigned long long ImageResources = 0;
+		unsigned long long LayerStructure = 0; // Layer and mask section except the channels.
+		unsigned long long LayerPixels = 0;
+		unsigned long long ImageData = 0;
+	};
+
+#pragma endregion
+
+#pragma region WRITER
+
+	//----------------------------------------------------------------------------------------------
+	// Every layer covers the canvas with ARGB channels of noisy runs, which compress about like
+	// painted textures. The content only depends on the parameters, seed included.
+	class PsdWriter
+	{
+	public:
+		static std::vector<unsigned char> Write(SyntheticParameters const& parameters, SectionSizes& sizes);
+		// Pixels written for a channel of a layer, ids -1 (transparency) to 2, as the reader decodes them.
+		static std::vector<unsigned char> LayerChannel(SyntheticParameters const& parameters, unsigned layer, short channelId);
+		// Pixels written for a plane of the merged image, 0 to 2.
+		static std::vector<unsigned char> CompositePlane(SyntheticParameters const& parameters, unsigned plane);
+
+	private:
+		static std::vector<unsigned char> MakePixels(SyntheticParameters const& parameters, unsigned seed);
+		static std::vector<unsigned char> EncodeChannel(SyntheticParameters const& parameters, std::vector<unsigned char> const& pixels, bool withCompression);
+		static std::vector<unsigned char> EncodeRle(SyntheticParameters const& parameters, std::vector<unsigned char> const& pixels);
+		static std::vector<unsigned char> Predict(SyntheticParameters const& parameters, std::vector<unsigned char> const& pixels);
+		static std::vector<unsigned char> Deflate(std::vector<unsigned char> const& data);
+		static std::vector<unsigned char> PathRecords(unsigned points, unsigned layerIndex);
+	};
+
+#pragma endregion
+}
+
+#endif // PSDWRITER_H
@@ -0,0 +1,301 @@
+//----------------------------------------------------------------------------------------------
+// ===============================================
+//  Copyright (C) 2026, E.D. Films.
+//  All Rights Reserved.
+// ===============================================
+//  Unauthorized copying of this file, via any medium is strictly prohibited
+//  Proprietary and confidential
+//
+//  @file readerBenchmark.cpp
+//  @author Michaelson Britt
+//  @date 16-10-2026
+//
+//  @section DESCRIPTION
+//  Times PsdReader::ParsePsd per section on synthetic documents, or on a given file, and
+//  prints the results as JSON. The pixels decoded from a synthetic document are compared with
+//  the ones written, the exit code is 1 when any differs.
+//
+//  psd_reader_benchmark [--layers N] [--width N] [--height N] [--depth 8|16|32]
+//                       [--compression raw|rle|zip|zip-prediction] [--mask-points N] [--psb]
+//                       [--seed N] [--iterations N] [--threads N] [--input file.psd]
+//                       [--save file.psd]
+//
+//----------------------------------------------------------------------------------------------
+
+#include "psdWriter.h"
+#include "psd_reader/psdReader.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+using namespace psd_benchmark;
+
+namespace
+{
+	//----------------------------------------------------------------------------------------
+	unsigned long long PeakResidentBytes()
+	{
+#ifdef _WIN32
+		PROCESS_MEMORY_COUNTERS counters;
+		if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+		return counters.PeakWorkingSetSize;
+#else
+		struct rusage usage;
+		if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+		return static_cast<unsigned long long>(usage.ru_maxrss);
+#else
+		return static_cast<unsigned long long>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+	}
+
+	//----------------------------------------------------------------------------------------
+	// Swallows the log of the reader, stdout only holds the JSON.
+	class NullBuffer : public std::streambuf
+	{
+	protected:
+		int overflow(int c) override { return c; }
+	};
+
+	//----------------------------------------------------------------------------------------
+	double Median(std::vector<double> values)
+	{
+		if (values.empty()) return 0;
+		std::sort(values.begin(), values.end());
+		const size_t middle = values.size() / 2;
+		return values.size() % 2 ? values[middle] : (values[middle - 1] + values[middle]) / 2;
+	}
+
+	//----------------------------------------------------------------------------------------
+	double MegabytesPerSecond(unsigned long long bytes, double seconds)
+	{
+		return seconds > 0 ? bytes / seconds / (1024.0 * 1024.0) : 0;
+	}
+
+	//----------------------------------------------------------------------------------------
+	const char* CompressionName(COMPRESSION compression)
+	{
+		switch (compression)
+		{
+		case RAW: return "raw";
+		case RLE: return "rle";
+		case ZIP: return "zip";
+		default: return "zip-prediction";
+		}
+	}
+
+	//----------------------------------------------------------------------------------------
+	// Layer channels and merged image planes decoded differently from what PsdWriter generated.
+	unsigned CountWrongChannels(SyntheticParameters const& synthetic, psd_reader::PsdData const& data)
+	{
+		unsigned wrong = 0;
+		for (unsigned layer = 0; layer < synthetic.LayerCount; ++layer)
+		{
+			// Written as "Layer N", the reader replaces the spaces of the names.
+			const int index = data.LayerMaskData.GetIndexLayer("Layer_" + std::to_string(layer));
+			for (short channelId = -1; channelId < 3; ++channelId)
+			{
+				const unsigned char* pixels = index < 0 ? nullptr : data.LayerMaskData.Layers[index].GetChannelContent(channelId);
+				const std::vector<unsigned char> expected = PsdWriter::LayerChannel(synthetic, layer, channelId);
+				if (pixels == nullptr || std::memcmp(pixels, expected.data(), expected.size()) != 0) ++wrong;
+			}
+		}
+
+		// Interleaved RGBA, the transparency is opaque since the document has 3 channels.
+		const size_t sampleBytes = synthetic.Depth / 8;
+		const size_t count = size_t(synthetic.Width) * synthetic.Height;
+		std::vector<unsigned char> const& rgba = data.ImageData.Rgba;
+		for (unsigned plane = 0; plane < 3; ++plane)
+		{
+			if (rgba.size() != count * 4 * sampleBytes)
+			{
+				++wrong;
+				continue;
+			}
+			const std::vector<unsigned char> expected = PsdWriter::CompositePlane(synthetic, plane);
+			for (size_t i = 0; i < count; ++i)
+			{
+				if (std::memcmp(&rgba[(i * 4 + plane) * sampleBytes], &expected[i * sampleBytes], sampleBytes) != 0)
+				{
+					++wrong;
+					break;
+				}
+			}
+		}
+		return wrong;
+	}
+
+	//----------------------------------------------------------------------------------------
+	bool ParseArguments(int argc, char** argv, SyntheticParameters& synthetic, unsigned& iterations, unsigned& threads, std::string& input, std::string& save)
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			const std::string name = argv[i];
+			if (name == "--psb")
+			{
+				synthetic.LargeDocument = true;
+				continue;
+			}
+			if (i + 1 >= argc) return false;
+			const std::string value = argv[++i];
+			const unsigned number = static_cast<unsigned>(std::strtoul(value.c_str(), nullptr, 10));
+
+			if (name == "--layers") synthetic.LayerCount = number;
+			else if (name == "--width") synthetic.Width = number;
+			else if (name == "--height") synthetic.Height = number;
+			else if (name == "--depth") synthetic.Depth = static_cast<unsigned short>(number);
+			else if (name == "--mask-points") synthetic.MaskPoints = number;
+			else if (name == "--seed") synthetic.Seed = number;
+			else if (name == "--iterations") iterations = std::max(1u, number);
+			else if (name == "--threads") threads = number;
+			else if (name == "--input") input = value;
+			else if (name == "--save") save = value;
+			else if (name == "--compression")
+			{
+				if (value == "raw") synthetic.Compression = RAW;
+				else if (value == "rle") synthetic.Compression = RLE;
+				else if (value == "zip") synthetic.Compression = ZIP;
+				else if (value == "zip-prediction") synthetic.Compression = ZIP_PREDICTION;
+				else return false;
+			}
+			else return false;
+		}
+		return synthetic.Depth == 8 || synthetic.Depth == 16 || synthetic.Depth == 32;
+	}
+}
+
+//----------------------------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+	SyntheticParameters synthetic;
+	unsigned iterations = 5;
+	unsigned threads = 0;
+	std::string input;
+	std::string save;
+	if (!ParseArguments(argc, argv, synthetic, iterations, threads, input, save))
+	{
+		std::fprintf(stderr, "usage: %s [--layers N] [--width N] [--height N] [--depth 8|16|32] [--compression raw|rle|zip|zip-prediction] "
+			"[--mask-points N] [--psb] [--seed N] [--iterations N] [--threads N] [--input file.psd] [--save file.psd]\n", argv[0]);
+		return 2;
+	}
+
+	// The document, written or read, stays in memory: the timings don't include the disk.
+	std::vector<unsigned char> document;
+	SectionSizes sizes;
+	if (input.empty())
+	{
+		document = PsdWriter::Write(synthetic, sizes);
+	}
+	else
+	{
+		std::ifstream file(input, std::ios::binary);
+		document.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	}
+	if (document.empty())
+	{
+		std::fprintf(stderr, "no document to parse\n");
+		return 1;
+	}
+	if (!save.empty())
+	{
+		std::ofstream(save, std::ios::binary).write(reinterpret_cast<const char*>(document.data()), document.size());
+	}
+
+	// Parsing again into the pixels of the previous parsing, as the plugin does on reload.
+	struct Samples
+	{
+		std::vector<double> Header, ColorMode, ImageResources, LayerStructure, LayerPixels, ImageData, Total;
+	} samples;
+	size_t layerCount = 0;
+	unsigned wrongChannels = 0;
+	std::shared_ptr<psd_reader::PixelArena> arena;
+	NullBuffer silent;
+	std::streambuf* log = std::cout.rdbuf(&silent);
+	for (unsigned i = 0; i < iterations; ++i)
+	{
+		psd_reader::PsdReader reader(document.data(), document.size());
+		psd_reader::ReaderParameters parameters;
+		parameters.ThreadCount = threads;
+		parameters.DecodeComposite = true;
+		reader.SetParameters(parameters);
+		reader.SetPixelArena(arena);
+		psd_reader::PsdData data = reader.ParsePsd();
+		arena = data.LayerMaskData.Pixels;
+		layerCount = data.LayerMaskData.Layers.size();
+
+		// Every iteration, a reused arena must not change the pixels. Not part of the timings.
+		if (input.empty()) wrongChannels += CountWrongChannels(synthetic, data);
+
+		psd_reader::SectionTimings const& timings = reader.GetSectionTimings();
+		samples.Header.push_back(timings.Source + timings.Header);
+		samples.ColorMode.push_back(timings.ColorMode);
+		samples.ImageResources.push_back(timings.ImageResources);
+		samples.LayerStructure.push_back(timings.LayerStructure);
+		samples.LayerPixels.push_back(timings.LayerPixels);
+		samples.ImageData.push_back(timings.ImageData + timings.Composite);
+		samples.Total.push_back(timings.Total());
+	}
+	std::cout.rdbuf(log);
+
+	// Median of the iterations, the bytes per section are only known for synthetic documents.
+	const double total = Median(samples.Total);
+	std::printf("{\n");
+	if (input.empty())
+	{
+		std::printf("  \"document\": {\"synthetic\": true, \"layers\": %u, \"width\": %u, \"height\": %u, \"depth\": %u, "
+			"\"compression\": \"%s\", \"mask_points\": %u, \"psb\": %s, \"seed\": %u, \"bytes\": %zu},\n",
+			synthetic.LayerCount, synthetic.Width, synthetic.Height, synthetic.Depth, CompressionName(synthetic.Compression),
+			synthetic.MaskPoints, synthetic.LargeDocument ? "true" : "false", synthetic.Seed, document.size());
+	}
+	else
+	{
+		std::printf("  \"document\": {\"synthetic\": false, \"bytes\": %zu},\n", document.size());
+	}
+	std::printf("  \"iterations\": %u,\n  \"threads\": %u,\n  \"sections\": {\n", iterations, threads);
+	const struct
+	{
+		const char* Name;
+		std::vector<double> const& Seconds;
+		unsigned long long Bytes;
+	} sections[] =
+	{
+		{ "header", samples.Header, sizes.Header },
+		{ "color_mode", samples.ColorMode, sizes.ColorMode },
+		{ "image_resources", samples.ImageResources, sizes.ImageResources },
+		{ "layer_structure", samples.LayerStructure, sizes.LayerStructure },
+		{ "layer_pixels", samples.LayerPixels, sizes.LayerPixels },
+		{ "image_data", samples.ImageData, sizes.ImageData },
+	};
+	const size_t sectionCount = sizeof(sections) / sizeof(sections[0]);
+	for (size_t s = 0; s < sectionCount; ++s)
+	{
+		const double seconds = Median(sections[s].Seconds);
+		std::printf("    \"%s\": {\"seconds\": %.6f, \"bytes\": %llu, \"mb_per_s\": %.2f}%s\n", sections[s].Name, seconds,
+			sections[s].Bytes, MegabytesPerSecond(sections[s].Bytes, seconds), s + 1 < sectionCount ? "," : "");
+	}
+	std::printf("  },\n");
+	std::printf("  \"total\": {\"seconds\": %.6f, \"mb_per_s\": %.2f, \"layers\": %zu, \"layers_per_s\": %.2f},\n",
+		total, MegabytesPerSecond(document.size(), total), layerCount, total > 0 ? layerCount / total : 0.0);
+	if (input.empty())
+	{
+		std::printf("  \"pixels\": {\"verified\": true, \"wrong_channels\": %u},\n", wrongChannels);
+	}
+	else
+	{
+		std::printf("  \"pixels\": {\"verified\": false},\n");
+	}
+	std::printf("  \"peak_rss_bytes\": %llu\n}\n", PeakResidentBytes());
+	return wrongChannels == 0 ? 0 : 1;
+}
@@ -0,0 +1,175 @@
+//----------------------------------------------------------------------------------------------
+// ===============================================
+//  Copyright (C) 2026, E.D. Films.
+//  All Rights Reserved.
+// ===============================================
+//  Unauthorized copying of this file, via any medium is strictly prohibited
+//  Proprietary and confidential
+//
+//  @file byteSource.cpp
+//  @author Michaelson Britt
+//  @date 16-10-2026
+//
+//  @section DESCRIPTION
+//
+//----------------------------------------------------------------------------------------------
+
+#include "byteSource.h"
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <share.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace psd_reader
+{
+	//----------------------------------------------------------------------------------------
+	static bool SeekFile(FILE* file, unsigned long long position)
+	{
+#ifdef _WIN32
+		return _fseeki64(file, static_cast<long long>(position), SEEK_SET) == 0;
+#else
+		return fseeko(file, static_cast<off_t>(position), SEEK_SET) == 0;
+#endif
+	}
+
+#pragma region BYTE SOURCE
+
+	//----------------------------------------------------------------------------------------
+	std::unique_ptr<ByteSource> ByteSource::Open(std::string const& path, SOURCE_BACKEND backend)
+	{
+		std::unique_ptr<ByteSource> source;
+		if (backend == MAPPED_SOURCE)
+		{
+			source.reset(new MappedByteSource(path));
+			if (source->IsOpen()) return source;
+			std::cout << "[PARSING PATH] Can't map the file, fallback on stdio." << std::endl;
+		}
+
+		source.reset(new StdioByteSource(path));
+		return source;
+	}
+
+#pragma endregion
+
+#pragma region MEMORY
+
+	//----------------------------------------------------------------------------------------
+	MemoryByteSource::MemoryByteSource(const unsigned char* data, size_t size)
+	{
+		this->Buffer = data;
+		this->BufferSize = data == nullptr ? 0 : size;
+	}
+
+	//----------------------------------------------------------------------------------------
+	const unsigned char* MemoryByteSource::View(unsigned long long offset, size_t size, std::vector<unsigned char>&) const
+	{
+		if (offset > this->BufferSize || size > this->BufferSize - offset) return nullptr;
+		return this->Buffer + offset;
+	}
+
+#pragma endregion
+
+#pragma region MAPPED
+
+	//----------------------------------------------------------------------------------------
+	MappedByteSource::MappedByteSource(std::string const& path)
+	{
+#ifdef _WIN32
+		// Same sharing as the stdio backend: others can read but not write while we parse.
+		HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE) return;
+		this->FileHandle = file;
+
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) return;
+
+		HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping == nullptr) return;
+		this->MappingHandle = mapping;
+
+		void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		if (view == nullptr) return;
+
+		this->Buffer = static_cast<const unsigned char*>(view);
+		this->BufferSize = static_cast<unsigned long long>(size.QuadPart);
+#else
+		const int descriptor = open(path.c_str(), O_RDONLY);
+		if (descriptor < 0) return;
+		this->FileDescriptor = descriptor;
+
+		struct stat status;
+		if (fstat(descriptor, &status) != 0 || status.st_size == 0) return;
+
+		void* view = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+		if (view == MAP_FAILED) return;
+		madvise(view, static_cast<size_t>(status.st_size), MADV_SEQUENTIAL);
+
+		this->Buffer = static_cast<const unsigned char*>(view);
+		this->BufferSize = static_cast<unsigned long long>(status.st_size);
+#endif
+	}
+
+	//----------------------------------------------------------------------------------------
+	MappedByteSource::~MappedByteSource()
+	{
+#ifdef _WIN32
+		if (this->Buffer != nullptr) UnmapViewOfFile(this->Buffer);
+		if (this->MappingHandle != nullptr) CloseHandle(this->MappingHandle);
+		if (this->FileHandle != nullptr) CloseHandle(this->FileHandle);
+#else
+		if (this->Buffer != nullptr) munmap(const_cast<unsigned char*>(this->Buffer), static_cast<size_t>(this->BufferSize));
+		if (this->FileDescriptor >= 0) close(this->FileDescriptor);
+#endif
+	}
+
+#pragma endregion
+
+#pragma region STDIO
+
+	//----------------------------------------------------------------------------------------
+	StdioByteSource::StdioByteSource(std::string const& path)
+	{
+#ifdef _WIN32
+		this->File = _fsopen(path.c_str(), "rb", _SH_DENYWR);
+#else
+		this->File = fopen(path.c_str(), "rb");
+#endif
+		if (this->File == nullptr) return;
+
+#ifdef _WIN32
+		_fseeki64(this->File, 0, SEEK_END);
+		this->FileSize = static_cast<unsigned long long>(_ftelli64(this->File));
+#else
+		fseeko(this->File, 0, SEEK_END);
+		this->FileSize = static_cast<unsigned long long>(ftello(this->File));
+#endif
+	}
+
+	//----------------------------------------------------------------------------------------
+	StdioByteSource::~StdioByteSource()
+	{
+		if (this->File != nullptr) fclose(this->File);
+	}
+
+	//----------------------------------------------------------------------------------------
+	const unsigned char* StdioByteSource::View(unsigned long long offset, size_t size, std::vector<unsigned char>& scratch) const
+	{
+		if (offset > this->FileSize || size > this->FileSize - offset) return nullptr;
+
+		scratch.resize(size);
+		std::lock_guard<std::mutex> lock(this->FileLock);
+		const bool success = SeekFile(this->File, offset) && fread(scratch.data(), 1, size, this->File) == size;
+		return success ? scratch.data() : nullptr;
+	}
+
+#pragma endregion
+}
@@ -0,0 +1,121 @@
+//----------------------------------------------------------------------------------------------
+// ===============================================
+//  Copyright (C) 2026, E.D. Films.
+//  All Rights Reserved.
+// ===============================================
+//  Unauthorized copying of this file, via any medium is strictly prohibited
+//  Proprietary and confidential
+//
+//  @file byteSource.h
+//  @author Michaelson Britt
+//  @date 16-10-2026
+//
+//  @section DESCRIPTION
+//  Access to the bytes of a PSD, either mapped in memory, from a buffer owned by the caller
+//  or through stdio.
+//
+//----------------------------------------------------------------------------------------------
+
+#ifndef BYTESOURCE_H
+#define BYTESOURCE_H
+
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace psd_reader
+{
+#pragma region DATA
+
+	//----------------------------------------------------------------------------------------------
+	enum SOURCE_BACKEND
+	{
+		MAPPED_SOURCE = 0, // Memory mapped file, default.
+		STDIO_SOURCE = 1 // Buffered stdio, fallback when the file can't be mapped.
+	};
+
+#pragma endregion
+
+#pragma region SOURCES
+
+	//----------------------------------------------------------------------------------------------
+	class ByteSource
+	{
+	public:
+		ByteSource() = default;
+		virtual ~ByteSource() = default;
+		ByteSource(ByteSource const&) = delete;
+		ByteSource& operator=(ByteSource const&) = delete;
+
+		virtual bool IsOpen() const = 0;
+		virtual unsigned long long Size() const = 0;
+
+		// Return a pointer on [offset, offset + size). Contiguous sources return their own memory,
+		// others copy into the scratch buffer. Safe between threads.
+		virtual const unsigned char* View(unsigned long long offset, size_t size, std::vector<unsigned char>& scratch) const = 0;
+
+		// Whole content when the source is contiguous in memory, nullptr otherwise.
+		virtual const unsigned char* Data() const { return nullptr; }
+
+		static std::unique_ptr<ByteSource> Open(std::string const& path, SOURCE_BACKEND backend);
+	};
+
+	//----------------------------------------------------------------------------------------------
+	// Buffer owned by the caller, must outlive the source.
+	//----------------------------------------------------------------------------------------------
+	class MemoryByteSource : public ByteSource
+	{
+	public:
+		MemoryByteSource(const unsigned char* data, size_t size);
+
+		bool IsOpen() const override { return this->Buffer != nullptr; }
+		unsigned long long Size() const override { return this->BufferSize; }
+		const unsigned char* View(unsigned long long offset, size_t size, std::vector<unsigned char>& scratch) const override;
+		const unsigned char* Data() const override { return this->Buffer; }
+
+	protected:
+		MemoryByteSource() = default;
+
+		const unsigned char* Buffer = nullptr;
+		unsigned long long BufferSize = 0;
+	};
+
+	//----------------------------------------------------------------------------------------------
+	class MappedByteSource : public MemoryByteSource
+	{
+	public:
+		MappedByteSource(std::string const& path);
+		~MappedByteSource();
+
+	private:
+#ifdef _WIN32
+		void* FileHandle = nullptr;
+		void* MappingHandle = nullptr;
+#else
+		int FileDescriptor = -1;
+#endif
+	};
+
+	//----------------------------------------------------------------------------------------------
+	class StdioByteSource : public ByteSource
+	{
+	public:
+		StdioByteSource(std::string const& path);
+		~StdioByteSource();
+
+		bool IsOpen() const override { return this->File != nullptr; }
+		unsigned long long Size() const override { return this->FileSize; }
+		const unsigned char* View(unsigned long long offset, size_t size, std::vector<unsigned char>& scratch) const override;
+
+	private:
+		FILE* File = nullptr;
+		unsigned long long FileSize = 0;
+		mutable std::mutex FileLock;
+	};
+
+#pragma endregion
+}
+
+#endif // BYTESOURCE_H
@@ -0,0 +1,79 @@
+//----------------------------------------------------------------------------------------------
+// ===============================================
+//  Copyright (C) 2026, E.D. Films.
+//  All Rights Reserved.
+// ===============================================
+//  Unauthorized copying of this file, via any medium is strictly prohibited
+//  Proprietary and confidential
+//
+//  @file cancellation.h
+//  @author Michaelson Britt
+//  @date 16-10-2026
+//
+//  @section DESCRIPTION
+//  Flag shared between the parsing and the thread which wants to abort it.
+//
+//----------------------------------------------------------------------------------------------
+
+#ifndef CANCELLATION_H
+#define CANCELLATION_H
+
+#include <atomic>
+#include <exception>
+#include <memory>
+
+namespace psd_reader
+{
+	//----------------------------------------------------------------------------------------------
+	// Thrown by the readers when the parsing is cancelled, caught by PsdReader.
+	class ParseCancelled : public std::exception
+	{
+	public:
+		const char* what() const noexcept override
+		{
+			return "PSD parsing cancelled";
+		}
+	};
+
+	//----------------------------------------------------------------------------------------------
+	// Copies share the same flag: cancelling any copy cancels them all.
+	class CancellationToken
+	{
+	public:
+		CancellationToken() : Flag(std::make_shared<std::atomic<bool>>(false)) {}
+
+		// New flag also cancelled by parent, cancelling it leaves parent alone.
+		static CancellationToken LinkedTo(CancellationToken const& parent)
+		{
+			CancellationToken token;
+			token.Parent = std::make_shared<const CancellationToken>(parent);
+			return token;
+		}
+
+		void Cancel() const
+		{
+			this->Flag->store(true, std::memory_order_relaxed);
+		}
+
+		void Reset() const
+		{
+			this->Flag->store(false, std::memory_order_relaxed);
+		}
+
+		bool IsCancelled() const
+		{
+			return this->Flag->load(std::memory_order_relaxed) || (this->Parent != nullptr && this->Parent->IsCancelled());
+		}
+
+		void ThrowIfCancelled() const
+		{
+			if (IsCancelled()) throw ParseCancelled();
+		}
+
+	private:
+		std::shared_ptr<std::atomic<bool>> Flag;
+		std::shared_ptr<const CancellationToken> Parent;
+	};
+}
+
+#endif // CANCELLATION_H
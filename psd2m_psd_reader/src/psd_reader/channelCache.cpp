@@ -0,0 +1,90 @@
+//----------------------------------------------------------------------------------------------
+// ===============================================
+//  Copyright (C) 2026, E.D. Films.
+//  All Rights Reserved.
+// ===============================================
+//  Unauthorized copying of this file, via any medium is strictly prohibited
+//  Proprietary and confidential
+//
+//  @file channelCache.cpp
+//  @author Michaelson Britt
+//  @date 16-10-2026
+//
+//  @section DESCRIPTION
+//
+//----------------------------------------------------------------------------------------------
+
+#include "channelCache.h"
+
+namespace psd_reader
+{
+	//----------------------------------------------------------------------------------------
+	void ChannelCache::SetBudget(unsigned long long budget)
+	{
+		std::lock_guard<std::mutex> guard(this->Lock);
+		this->Budget = budget;
+		Evict(Key(-1, 0));
+	}
+
+	//----------------------------------------------------------------------------------------
+	ChannelPixels ChannelCache::Get(Key const& key)
+	{
+		std::lock_guard<std::mutex> guard(this->Lock);
+		const auto found = this->Entries.find(key);
+		if (found == this->Entries.end()) return nullptr;
+
+		this->UseOrder.splice(this->UseOrder.begin(), this->UseOrder, found->second.Use);
+		return found->second.Pixels;
+	}
+
+	//----------------------------------------------------------------------------------------
+	void ChannelCache::Put(Key const& key, ChannelPixels const& pixels, unsigned long long size)
+	{
+		std::lock_guard<std::mutex> guard(this->Lock);
+		const auto found = this->Entries.find(key);
+		if (found != this->Entries.end())
+		{
+			// Decoded twice by concurrent callers, keep the latest.
+			this->TotalSize -= found->second.Size;
+			this->UseOrder.erase(found->second.Use);
+			this->Entries.erase(found);
+		}
+
+		this->UseOrder.push_front(key);
+		this->Entries[key] = Entry{ pixels, size, this->UseOrder.begin() };
+		this->TotalSize += size;
+		Evict(key);
+	}
+
+	//----------------------------------------------------------------------------------------
+	void ChannelCache::Clear()
+	{
+		std::lock_guard<std::mutex> guard(this->Lock);
+		this->Entries.clear();
+		this->UseOrder.clear();
+		this->TotalSize = 0;
+	}
+
+	//----------------------------------------------------------------------------------------
+	unsigned long long ChannelCache::Size() const
+	{
+		std::lock_guard<std::mutex> guard(this->Lock);
+		return this->TotalSize;
+	}
+
+	//----------------------------------------------------------------------------------------
+	void ChannelCache::Evict(Key const& keep)
+	{
+		// A budget of 0 is unlimited. The channel just added stays even if it's bigger than the budget.
+		while (this->Budget > 0 && this->TotalSize > this->Budget && !this->UseOrder.empty())
+		{
+			const Key oldest = this->UseOrder.back();
+			if (oldest == keep) break;
+
+			const auto found = this->Entries.find(oldest);
+			this->TotalSize -= found->second.Size;
+			this->Entries.erase(found);
+			this->UseOrder.pop_back();
+		}
+	}
+}
@@ -0,0 +1,73 @@
+//----------------------------------------------------------------------------------------------
+// ===============================================
+//  Copyright (C) 2026, E.D. Films.
+//  All Rights Reserved.
+// ===============================================
+//  Unauthorized copying of this file, via any medium is strictly prohibited
+//  Proprietary and confidential
+//
+//  @file channelCache.h
+//  @author Michaelson Britt
+//  @date 16-10-2026
+//
+//  @section DESCRIPTION
+//  Decoded channels kept under a memory budget, the least recently used are evicted first.
+//
+//----------------------------------------------------------------------------------------------
+
+#ifndef CHANNELCACHE_H
+#define CHANNELCACHE_H
+
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+namespace psd_reader
+{
+#pragma region DATA
+
+	// Pixels of one channel. Evicting a channel doesn't free pixels still held by a caller.
+	typedef std::shared_ptr<const unsigned char> ChannelPixels;
+
+#pragma endregion
+
+#pragma region CACHE
+
+	//----------------------------------------------------------------------------------------------
+	class ChannelCache
+	{
+	public:
+		typedef std::pair<int, short> Key; // Layer index, channel id.
+
+		ChannelCache() = default;
+		~ChannelCache() = default;
+
+		void SetBudget(unsigned long long budget);
+		ChannelPixels Get(Key const& key);
+		void Put(Key const& key, ChannelPixels const& pixels, unsigned long long size);
+		void Clear();
+		unsigned long long Size() const;
+
+	private:
+		struct Entry
+		{
+			ChannelPixels Pixels;
+			unsigned long long Size;
+			std::list<Key>::iterator Use;
+		};
+
+		unsigned long long Budget = 0;
+		unsigned long long TotalSize = 0;
+		std::list<Key> UseOrder; // Most recently used first.
+		std::map<Key, Entry> Entries;
+		mutable std::mutex Lock;
+
+		void Evict(Key const& keep);
+	};
+
+#pragma endregion
+}
+
+#endif // CHANNELCACHE_H
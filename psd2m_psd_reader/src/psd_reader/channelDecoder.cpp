@@ -0,0 +1,399 @@
+//----------------------------------------------------------------------------------------------
+// ===============================================
+//  Copyright (C) 2026, E.D. Films.
+//  All Rights Reserved.
+// ===============================================
+//  Unauthorized copying of this file, via any medium is strictly prohibited
+//  Proprietary and confidential
+//
+//  @file channelDecoder.cpp
+//  @author Michaelson Britt
+//  @date 16-10-2026
+//
+//  @section DESCRIPTION
+//
+//----------------------------------------------------------------------------------------------
+
+#include "channelDecoder.h"
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define PSD_READER_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// GCC and Clang only emit the instructions in the functions marked for them, MSVC needs no flag.
+#if defined(__GNUC__) || defined(__clang__)
+#define PSD_READER_TARGET(set) __attribute__((target(set)))
+#else
+#define PSD_READER_TARGET(set)
+#endif
+
+namespace psd_reader
+{
+	//----------------------------------------------------------------------------------------
+	bool ChannelDecoder::DecodeRleRow(const unsigned char* source, size_t sourceLength, unsigned char* destination, size_t rowBytes)
+	{
+		const unsigned char* in = source;
+		const unsigned char* const inEnd = source + sourceLength;
+		unsigned char* out = destination;
+		unsigned char* const outEnd = destination + rowBytes;
+
+		while (in < inEnd)
+		{
+			const int header = static_cast<signed char>(*in++);
+			if (header >= 0)
+			{
+				// Literal run: the next header + 1 bytes are copied as is.
+				const size_t count = size_t(header) + 1;
+				if (count > size_t(inEnd - in) || count > size_t(outEnd - out)) break;
+				memcpy(out, in, count);
+				in += count;
+				out += count;
+			}
+			else if (header != -128)
+			{
+				// Repeat run: the next byte is repeated 1 - header times.
+				const size_t count = size_t(1 - header);
+				if (in == inEnd || count > size_t(outEnd - out)) break;
+				memset(out, *in++, count);
+				out += count;
+			}
+			// -128 is a no-op.
+		}
+
+		if (out == outEnd) return true;
+
+		memset(out, 0, size_t(outEnd - out));
+		return false;
+	}
+
+	//----------------------------------------------------------------------------------------
+	bool ChannelDecoder::DecodeRle(const unsigned char* source, size_t sourceLength, std::vector<unsigned int> const& rowSizes, unsigned char* destination, size_t rowBytes, CancellationToken const* cancellation)
+	{
+		bool success = true;
+		size_t offset = 0;
+
+		for (size_t row = 0; row < rowSizes.size(); ++row)
+		{
+			if (cancellation != nullptr) cancellation->ThrowIfCancelled();
+
+			unsigned char* rowDestination = destination + row * rowBytes;
+			const size_t rowSize = rowSizes[row];
+			if (rowSize > sourceLength - offset)
+			{
+				// The counts point past the channel data, the remaining rows are left empty.
+				memset(rowDestination, 0, (rowSizes.size() - row) * rowBytes);
+				return false;
+			}
+
+			success &= DecodeRleRow(source + offset, rowSize, rowDestination, rowBytes);
+			offset += rowSize;
+		}
+		return success;
+	}
+
+#pragma region PREDICTION
+
+	//----------------------------------------------------------------------------------------
+	// Scalar kernels, also used for the tail of the rows.
+	static void PrefixSum8(unsigned char* row, size_t start, size_t count)
+	{
+		unsigned char sum = start > 0 ? row[start - 1] : 0;
+		for (size_t i = start; i < count; ++i)
+		{
+			sum += row[i];
+			row[i] = sum;
+		}
+	}
+
+	//----------------------------------------------------------------------------------------
+	static void PrefixSum16(unsigned char* row, size_t start, size_t count)
+	{
+		unsigned short sum = start > 0 ? static_cast<unsigned short>(row[2 * start - 2] << 8 | row[2 * start - 1]) : 0;
+		for (size_t i = start; i < count; ++i)
+		{
+			sum = static_cast<unsigned short>(sum + (row[2 * i] << 8 | row[2 * i + 1]));
+			row[2 * i] = static_cast<unsigned char>(sum >> 8);
+			row[2 * i + 1] = static_cast<unsigned char>(sum);
+		}
+	}
+
+	//----------------------------------------------------------------------------------------
+	static void InterleavePlanes(const unsigned char* const* planes, unsigned char* destination, size_t start, size_t count, size_t sampleBytes)
+	{
+		unsigned char* out = destination + start * 4 * sampleBytes;
+		for (size_t i = start; i < count; ++i)
+		{
+			for (int plane = 0; plane < 4; ++plane)
+			{
+				memcpy(out, planes[plane] + i * sampleBytes, sampleBytes);
+				out += sampleBytes;
+			}
+		}
+	}
+
+#ifdef PSD_READER_X86
+
+	//----------------------------------------------------------------------------------------
+	// SSE4 kernels, 16 bytes at a time: log2(16) shifted adds then the carry of the previous block.
+	PSD_READER_TARGET("sse4.1")
+	static void PrefixSum8Sse4(unsigned char* row, size_t count)
+	{
+		const __m128i last = _mm_set1_epi8(15);
+		__m128i carry = _mm_setzero_si128();
+		size_t i = 0;
+		for (; i + 16 <= count; i += 16)
+		{
+			__m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i));
+			x = _mm_add_epi8(x, _mm_slli_si128(x, 1));
+			x = _mm_add_epi8(x, _mm_slli_si128(x, 2));
+			x = _mm_add_epi8(x, _mm_slli_si128(x, 4));
+			x = _mm_add_epi8(x, _mm_slli_si128(x, 8));
+			x = _mm_add_epi8(x, carry);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(row + i), x);
+			carry = _mm_shuffle_epi8(x, last);
+		}
+		PrefixSum8(row, i, count);
+	}
+
+	//----------------------------------------------------------------------------------------
+	PSD_READER_TARGET("sse4.1")
+	static void PrefixSum16Sse4(unsigned char* row, size_t count)
+	{
+		// Samples are big-endian, swapped to add them as words.
+		const __m128i swap = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+		const __m128i last = _mm_setr_epi8(14, 15, 14, 15, 14, 15, 14, 15, 14, 15, 14, 15, 14, 15, 14, 15);
+		__m128i carry = _mm_setzero_si128();
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			__m128i x = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row + 2 * i)), swap);
+			x = _mm_add_epi16(x, _mm_slli_si128(x, 2));
+			x = _mm_add_epi16(x, _mm_slli_si128(x, 4));
+			x = _mm_add_epi16(x, _mm_slli_si128(x, 8));
+			x = _mm_add_epi16(x, carry);
+			carry = _mm_shuffle_epi8(x, last);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(row + 2 * i), _mm_shuffle_epi8(x, swap));
+		}
+		PrefixSum16(row, i, count);
+	}
+
+	//----------------------------------------------------------------------------------------
+	// Four planes of 16 bytes give 64 interleaved bytes: unpacking pairs of planes at the sample
+	// size, then the pairs at twice the sample size.
+	PSD_READER_TARGET("sse4.1")
+	static void InterleaveSse4(const unsigned char* const* planes, unsigned char* destination, size_t count, size_t sampleBytes)
+	{
+		const size_t step = 16 / sampleBytes;
+		size_t i = 0;
+		for (; i + step <= count; i += step)
+		{
+			const size_t offset = i * sampleBytes;
+			const __m128i p0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(planes[0] + offset));
+			const __m128i p1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(planes[1] + offset));
+			const __m128i p2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(planes[2] + offset));
+			const __m128i p3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(planes[3] + offset));
+
+			__m128i low01, high01, low23, high23, out[4];
+			switch (sampleBytes)
+			{
+			case 1:
+				low01 = _mm_unpacklo_epi8(p0, p1);
+				high01 = _mm_unpackhi_epi8(p0, p1);
+				low23 = _mm_unpacklo_epi8(p2, p3);
+				high23 = _mm_unpackhi_epi8(p2, p3);
+				out[0] = _mm_unpacklo_epi16(low01, low23);
+				out[1] = _mm_unpackhi_epi16(low01, low23);
+				out[2] = _mm_unpacklo_epi16(high01, high23);
+				out[3] = _mm_unpackhi_epi16(high01, high23);
+				break;
+			case 2:
+				low01 = _mm_unpacklo_epi16(p0, p1);
+				high01 = _mm_unpackhi_epi16(p0, p1);
+				low23 = _mm_unpacklo_epi16(p2, p3);
+				high23 = _mm_unpackhi_epi16(p2, p3);
+				out[0] = _mm_unpacklo_epi32(low01, low23);
+				out[1] = _mm_unpackhi_epi32(low01, low23);
+				out[2] = _mm_unpacklo_epi32(high01, high23);
+				out[3] = _mm_unpackhi_epi32(high01, high23);
+				break;
+			default:
+				low01 = _mm_unpacklo_epi32(p0, p1);
+				high01 = _mm_unpackhi_epi32(p0, p1);
+				low23 = _mm_unpacklo_epi32(p2, p3);
+				high23 = _mm_unpackhi_epi32(p2, p3);
+				out[0] = _mm_unpacklo_epi64(low01, low23);
+				out[1] = _mm_unpackhi_epi64(low01, low23);
+				out[2] = _mm_unpacklo_epi64(high01, high23);
+				out[3] = _mm_unpackhi_epi64(high01, high23);
+				break;
+			}
+
+			__m128i* destinationBlock = reinterpret_cast<__m128i*>(destination + 4 * offset);
+			for (int k = 0; k < 4; ++k)
+			{
+				_mm_storeu_si128(destinationBlock + k, out[k]);
+			}
+		}
+		InterleavePlanes(planes, destination, i, count, sampleBytes);
+	}
+
+	//----------------------------------------------------------------------------------------
+	// AVX2 kernels, 32 bytes at a time. The shifts stay within each 128-bit lane, the last value
+	// of the low lane is then added to the high lane.
+	PSD_READER_TARGET("avx2")
+	static void PrefixSum8Avx2(unsigned char* row, size_t count)
+	{
+		const __m256i last = _mm256_set1_epi8(15);
+		__m256i carry = _mm256_setzero_si256();
+		size_t i = 0;
+		for (; i + 32 <= count; i += 32)
+		{
+			__m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + i));
+			x = _mm256_add_epi8(x, _mm256_slli_si256(x, 1));
+			x = _mm256_add_epi8(x, _mm256_slli_si256(x, 2));
+			x = _mm256_add_epi8(x, _mm256_slli_si256(x, 4));
+			x = _mm256_add_epi8(x, _mm256_slli_si256(x, 8));
+			const __m256i lanes = _mm256_shuffle_epi8(x, last);
+			x = _mm256_add_epi8(x, _mm256_permute2x128_si256(lanes, lanes, 0x08));
+			x = _mm256_add_epi8(x, carry);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(row + i), x);
+			const __m256i ends = _mm256_shuffle_epi8(x, last);
+			carry = _mm256_permute2x128_si256(ends, ends, 0x11);
+		}
+		PrefixSum8(row, i, count);
+	}
+
+	//----------------------------------------------------------------------------------------
+	PSD_READER_TARGET("avx2")
+	static void PrefixSum16Avx2(unsigned char* row, size_t count)
+	{
+		const __m256i swap = _mm256_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+			1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+		const __m256i last = _mm256_setr_epi8(14, 15, 14, 15, 14, 15, 14, 15, 14, 15, 14, 15, 14, 15, 14, 15,
+			14, 15, 14, 15, 14, 15, 14, 15, 14, 15, 14, 15, 14, 15, 14, 15);
+		__m256i carry = _mm256_setzero_si256();
+		size_t i = 0;
+		for (; i + 16 <= count; i += 16)
+		{
+			__m256i x = _mm256_shuffle_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + 2 * i)), swap);
+			x = _mm256_add_epi16(x, _mm256_slli_si256(x, 2));
+			x = _mm256_add_epi16(x, _mm256_slli_si256(x, 4));
+			x = _mm256_add_epi16(x, _mm256_slli_si256(x, 8));
+			const __m256i lanes = _mm256_shuffle_epi8(x, last);
+			x = _mm256_add_epi16(x, _mm256_permute2x128_si256(lanes, lanes, 0x08));
+			x = _mm256_add_epi16(x, carry);
+			const __m256i ends = _mm256_shuffle_epi8(x, last);
+			carry = _mm256_permute2x128_si256(ends, ends, 0x11);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(row + 2 * i), _mm256_shuffle_epi8(x, swap));
+		}
+		PrefixSum16(row, i, count);
+	}
+
+#endif
+
+	//----------------------------------------------------------------------------------------
+	INSTRUCTION_SET ChannelDecoder::SupportedInstructionSet()
+	{
+		static const INSTRUCTION_SET supported = []()
+		{
+#if defined(PSD_READER_X86) && defined(_MSC_VER)
+			int info[4];
+			__cpuid(info, 0);
+			const int maxLeaf = info[0];
+			__cpuid(info, 1);
+			const bool sse4 = (info[2] & (1 << 19)) != 0;
+			const bool osSavesAvx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 6) == 6;
+			bool avx2 = false;
+			if (maxLeaf >= 7 && osSavesAvx)
+			{
+				__cpuidex(info, 7, 0);
+				avx2 = (info[1] & (1 << 5)) != 0;
+			}
+			return avx2 ? AVX2_SET : sse4 ? SSE4_SET : SCALAR_SET;
+#elif defined(PSD_READER_X86)
+			__builtin_cpu_init();
+			return __builtin_cpu_supports("avx2") ? AVX2_SET : __builtin_cpu_supports("sse4.1") ? SSE4_SET : SCALAR_SET;
+#else
+			return SCALAR_SET;
+#endif
+		}();
+		return supported;
+	}
+
+	//----------------------------------------------------------------------------------------
+	void ChannelDecoder::UndoPrediction(unsigned char* data, size_t rows, size_t cols, int depth)
+	{
+		UndoPrediction(data, rows, cols, depth, SupportedInstructionSet());
+	}
+
+	//----------------------------------------------------------------------------------------
+	void ChannelDecoder::UndoPrediction(unsigned char* data, size_t rows, size_t cols, int depth, INSTRUCTION_SET instructionSet)
+	{
+		if (depth != 8 && depth != 16 && depth != 32) return;
+
+		void (*prefixSum8)(unsigned char*, size_t) = [](unsigned char* row, size_t count) { PrefixSum8(row, 0, count); };
+		void (*prefixSum16)(unsigned char*, size_t) = [](unsigned char* row, size_t count) { PrefixSum16(row, 0, count); };
+#ifdef PSD_READER_X86
+		if (instructionSet >= SSE4_SET)
+		{
+			prefixSum8 = PrefixSum8Sse4;
+			prefixSum16 = PrefixSum16Sse4;
+		}
+		if (instructionSet >= AVX2_SET)
+		{
+			prefixSum8 = PrefixSum8Avx2;
+			prefixSum16 = PrefixSum16Avx2;
+		}
+#endif
+
+		const size_t rowBytes = cols * (depth / 8);
+		std::vector<unsigned char> planes(depth == 32 ? rowBytes : 0);
+		const unsigned char* const planeStarts[4] = { planes.data(), planes.data() + cols, planes.data() + 2 * cols, planes.data() + 3 * cols };
+		for (size_t r = 0; r < rows; ++r)
+		{
+			unsigned char* row = data + r * rowBytes;
+			switch (depth)
+			{
+			case 8:
+				prefixSum8(row, cols);
+				break;
+			case 16:
+				prefixSum16(row, cols);
+				break;
+			case 32:
+				// The delta runs over the whole row of bytes, the 4 planes of bytes are then regrouped per sample.
+				memcpy(planes.data(), row, rowBytes);
+				prefixSum8(planes.data(), rowBytes);
+				Interleave(planeStarts, row, cols, 1, instructionSet);
+				break;
+			}
+		}
+	}
+
+	//----------------------------------------------------------------------------------------
+	void ChannelDecoder::Interleave(const unsigned char* const planes[4], unsigned char* destination, size_t count, int sampleBytes)
+	{
+		Interleave(planes, destination, count, sampleBytes, SupportedInstructionSet());
+	}
+
+	//----------------------------------------------------------------------------------------
+	void ChannelDecoder::Interleave(const unsigned char* const planes[4], unsigned char* destination, size_t count, int sampleBytes, INSTRUCTION_SET instructionSet)
+	{
+#ifdef PSD_READER_X86
+		// Interleaving is bound by memory, the AVX2 path uses the SSE4 kernel.
+		if (instructionSet >= SSE4_SET && (sampleBytes == 1 || sampleBytes == 2 || sampleBytes == 4))
+		{
+			InterleaveSse4(planes, destination, count, size_t(sampleBytes));
+			return;
+		}
+#endif
+		InterleavePlanes(planes, destination, 0, count, size_t(sampleBytes));
+	}
+
+#pragma endregion
+}
@@ -0,0 +1,69 @@
+//----------------------------------------------------------------------------------------------
+// ===============================================
+//  Copyright (C) 2026, E.D. Films.
+//  All Rights Reserved.
+// ===============================================
+//  Unauthorized copying of this file, via any medium is strictly prohibited
+//  Proprietary and confidential
+//
+//  @file channelDecoder.h
+//  @author Michaelson Britt
+//  @date 16-10-2026
+//
+//  @section DESCRIPTION
+//  Decoders of the compressed channel data, shared by the layers and the merged image.
+//
+//----------------------------------------------------------------------------------------------
+
+#ifndef CHANNELDECODER_H
+#define CHANNELDECODER_H
+
+#include <cstddef>
+#include <vector>
+#include "cancellation.h"
+
+namespace psd_reader
+{
+#pragma region DATA
+
+	//----------------------------------------------------------------------------------------------
+	enum INSTRUCTION_SET
+	{
+		SCALAR_SET = 0,
+		SSE4_SET = 1,
+		AVX2_SET = 2
+	};
+
+#pragma endregion
+
+#pragma region DECODER
+
+	//----------------------------------------------------------------------------------------------
+	class ChannelDecoder
+	{
+	public:
+		// PackBits of a single row. A row which doesn't expand to exactly rowBytes is completed
+		// with zeros and reported as failed.
+		static bool DecodeRleRow(const unsigned char* source, size_t sourceLength, unsigned char* destination, size_t rowBytes);
+
+		// PackBits of consecutive rows, rowSizes being the compressed byte count of each row as
+		// stored ahead of the data. The cancellation, if any, is checked between the rows.
+		static bool DecodeRle(const unsigned char* source, size_t sourceLength, std::vector<unsigned int> const& rowSizes, unsigned char* destination, size_t rowBytes, CancellationToken const* cancellation = nullptr);
+
+		// Undo the horizontal prediction of ZIP channels in place, rows of cols samples of 8, 16 or 32 bits.
+		// 32-bit rows are stored byte planar, they are put back as big-endian samples.
+		static void UndoPrediction(unsigned char* data, size_t rows, size_t cols, int depth);
+		static void UndoPrediction(unsigned char* data, size_t rows, size_t cols, int depth, INSTRUCTION_SET instructionSet);
+
+		// Group 4 planes of count samples into consecutive samples of the 4 planes, RGBA from planar channels.
+		static void Interleave(const unsigned char* const planes[4], unsigned char* destination, size_t count, int sampleBytes);
+		static void Interleave(const unsigned char* const planes[4], unsigned char* destination, size_t count, int sampleBytes, INSTRUCTION_SET instructionSet);
+
+		// Best instruction set of the running CPU, checked once.
+		static INSTRUCTION_SET SupportedInstructionSet();
+	};
+
+#pragma endregion
+}
+
+#endif // CHANNELDECODER_H
@@ -17,14 +17,14 @@
 #include <string>
 #include <iostream>
 #include "colorModeReader.h"
-#include "util/utils.h"
+#include "util/bigEndianCursor.h"
 
 using namespace util;
 
 namespace psd_reader
 {
 	//----------------------------------------------------------------------------------------
-	bool ColorModeReader::Read(FILE* pFile, ColorModeData& colorModeInfo)
+	bool ColorModeReader::Read(BigEndianCursor& cursor, ColorModeData& colorModeInfo)
 	{
 		if (colorModeInfo.Length > 0)
 		{
@@ -33,9 +33,7 @@ namespace psd_reader
 		colorModeInfo.ColorData = nullptr;
 
 		// Get the length
-		unsigned char length[4];
-		fread(&length, sizeof(length), 1, pFile);
-		colorModeInfo.Length = Utils::Calculate(length, sizeof(colorModeInfo.Length));
+		colorModeInfo.Length = cursor.Read<int>();
 		const std::string mess("[COLOR MODE DATA] Size " + std::to_string(colorModeInfo.Length));
 
 		std::cout << mess << std::endl;
@@ -44,8 +42,7 @@ namespace psd_reader
 
 		// Get the Color Data.
 		colorModeInfo.ColorData = new unsigned char[colorModeInfo.Length];	
-		memset(colorModeInfo.ColorData, 254, colorModeInfo.Length);
-		fread(colorModeInfo.ColorData, colorModeInfo.Length, 1, pFile);
+		cursor.ReadBytes(colorModeInfo.ColorData, colorModeInfo.Length);
 		return true;
 	}
 }
@@ -18,6 +18,7 @@
 #define COLORMODEREADER_H
 
 #include <fstream>
+#include "util/bigEndianCursor.h"
 
 namespace psd_reader
 {
@@ -49,7 +50,7 @@ namespace psd_reader
 	class ColorModeReader
 	{
 	public:
-		static bool Read(FILE* pFile, ColorModeData& colorModeInfo);
+		static bool Read(util::BigEndianCursor& cursor, ColorModeData& colorModeInfo);
 	};
 
 #pragma endregion
@@ -18,6 +18,7 @@
 #define HEADERREADER_H
 
 #include <fstream>
+#include "util/bigEndianCursor.h"
 
 namespace psd_reader
 {
@@ -26,6 +27,7 @@ namespace psd_reader
 	//----------------------------------------------------------------------------------------------
 	struct HeaderData
 	{
+		short Version; // 1 for PSD, 2 for PSB (large document format) which stores most lengths on 8 bytes.
 		short Channels; // The number of channels in the image, including any alpha channels. Supported range is 1 to 56.
 		int Height; // The height of the image in pixels. Supported range is 1 to 30,000. (**PSB** max of 300, 000.)
 		int Width; // The width of the image in pixels. Supported range is 1 to 30,000. (*PSB** max of 300, 000)
@@ -34,6 +36,7 @@ namespace psd_reader
 
 		HeaderData()
 		{
+			Version = -1;
 			Channels = -1;
 			Height = -1;
 			Width = -1;
@@ -41,6 +44,20 @@ namespace psd_reader
 			ColourMode = -1;
 		};
 		~HeaderData() {};
+
+		bool IsLargeDocument() const { return Version == 2; }
+
+		// Section lengths, channel lengths and some additional layer info lengths: 8 bytes in a PSB, 4 in a PSD.
+		unsigned long long ReadLength(util::BigEndianCursor& cursor) const
+		{
+			return IsLargeDocument() ? cursor.Read<unsigned long long>() : cursor.Read<unsigned int>();
+		}
+
+		// Compressed size of each RLE row: 4 bytes in a PSB, 2 in a PSD.
+		unsigned int ReadRleRowSize(util::BigEndianCursor& cursor) const
+		{
+			return IsLargeDocument() ? cursor.Read<unsigned int>() : cursor.Read<unsigned short>();
+		}
 	};
 
 #pragma endregion
@@ -51,7 +68,9 @@ namespace psd_reader
 	class HeaderReader
 	{
 	public:
-		static bool Read(FILE* file, HeaderData& headerData);
+		static const unsigned SIZE = 26; // Bytes of the header, the color mode section follows.
+
+		static bool Read(util::BigEndianCursor& cursor, HeaderData& headerData);
 	};
 
 #pragma endregion
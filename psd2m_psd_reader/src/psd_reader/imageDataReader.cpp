@@ -14,396 +14,192 @@
 //
 //----------------------------------------------------------------------------------------------
 
+#include <algorithm>
+#include <atomic>
+#include <cstring>
 #include <iostream>
 #include "imageDataReader.h"
-#include "util/utils.h"
+#include "channelDecoder.h"
+#include "inflater.h"
+#include "util/parallel.h"
 
 namespace psd_reader
 {
-	ImageData::ImageData()
-	{
-		Data = nullptr;
-	} 
-	
 	//----------------------------------------------------------------------------------------
-	ImageData::~ImageData()
+	bool ImageDataReader::Read(util::BigEndianCursor& cursor, ImageData& combinedImage, HeaderData const& headerInfo)
 	{
-		delete Data;
+		if (cursor.Remaining() < 2) return false;
+
+		combinedImage.Offset = cursor.Offset();
+		combinedImage.Compression = cursor.Read<short>();
+		combinedImage.Width = headerInfo.Width;
+		combinedImage.Height = headerInfo.Height;
+		combinedImage.BitsPerPixel = headerInfo.BitsPerPixel;
+		combinedImage.Rgba.clear();
+		return true;
 	}
 
-
 	//----------------------------------------------------------------------------------------
-	bool ImageDataReader::Read(FILE* file, ImageData& combinedImage, ResolutionInfo const& resInfo, HeaderData const& headerInfo)
+	bool ImageDataReader::Decode(util::BigEndianCursor const& file, ImageData& combinedImage, HeaderData const& headerInfo, ReaderParameters const& parameters)
 	{
-		// Not implemented In the project
+		if (combinedImage.Offset == 0) return false;
 
-
-		/*if (!feof(file))
+		const int depth = headerInfo.BitsPerPixel;
+		if (depth != 8 && depth != 16 && depth != 32)
 		{
-			// Read Compression method
-			unsigned char compValue[2];
-			fread(&compValue, sizeof(compValue), 1, file);
-			const auto compression = short(util::Utils::Calculate(compValue, sizeof(compValue)));
-
-			switch (compression)
-			{
-				// raw data
-			case 0:
-			{
-				std::cout << "[ImageDataReader] Raw Data" << std::endl;
-				RawDataReader(file, combinedImage, resInfo, headerInfo);
-			}
-			break;
-
-			// RLE compression
-			case 1:
-			{
-				std::cout << "[ImageDataReader] RLE compression" << std::endl;
-				RleCompressionReader(file, combinedImage, resInfo, headerInfo);
-			}
-			break;
-
-			// ZIP without prediction
-			case 2:
-			{
-				std::cout << "[ImageDataReader] ZIP without prediction, not implemented" << std::endl;
-			}
-			break;
-
-			// ZIP with prediction
-			case 3:
-			{
-				std::cout << "[ImageDataReader] ZIP with prediction, not implemented" << std::endl;
-			}
-			break;
-
-			default:
-			{
-				std::cout << "[ImageDataReader] No compression found" << std::endl;
-			}
-
-			}
-		}*/
-		return  true;
-	}
-
-
-	//----------------------------------------------------------------------------------------
-	void ImageDataReader::RleCompressionReader(FILE* file, ImageData& combinedImage, ResolutionInfo const& resInfo, HeaderData const& headerInfo)
-	{
-		const int headerWidth = headerInfo.Width;
-		const int headerHeight = headerInfo.Height;
-		const int bytesPerPixelPerChannel = headerInfo.BitsPerPixel / 8;
-
-		const int pixels = headerWidth * headerHeight;
-		const int totalBytes = pixels * bytesPerPixelPerChannel * headerInfo.Channels;
-
-		auto* dataImage = new unsigned char[totalBytes];
-		memset(dataImage, 254, totalBytes);
-
-		unsigned char* p = dataImage;
-		int value;
-
-		unsigned char byteValue[1];
-
-		// The RLE-compressed data is preceded by a 2-byte data count for each row in the data,
-		// which we're going to just skip.
-		fseek(file, headerHeight * headerInfo.Channels * 2, SEEK_CUR);
+			std::cout << "[ImageDataReader] Depth " << depth << " not implemented" << std::endl;
+			return false;
+		}
 
-		for (int channel = 0; channel < headerInfo.Channels; channel++)
+		// RGB = 3, Grayscale = 1. The first extra channel is the transparency.
+		int colourPlanes;
+		switch (headerInfo.ColourMode)
 		{
-			// Read the RLE data.
-			int count = 0;
-			while (count < pixels)
-			{
-				fread(&byteValue, sizeof(byteValue), 1, file);
-
-				int len = util::Utils::Calculate(byteValue, sizeof(byteValue));
-				if (128 > len)
-				{
-					len++;
-					count += len;
-
-					while (len)
-					{
-						fread(&byteValue, sizeof(byteValue), 1, file);
-
-						value = util::Utils::Calculate(byteValue, sizeof(byteValue));
-
-						*p = value;
-						p += sizeof(byteValue);
-						len--;
-					}
-				}
-				else if (128 < len)
-				{
-					// Next -len+1 bytes in the dest are replicated from next source byte.
-					// (Interpret len as a negative 8-bit int.)
-					len ^= 0x0FF;
-					len += 2;
-					fread(&byteValue, sizeof(byteValue), 1, file);
-
-					value = util::Utils::Calculate(byteValue, sizeof(byteValue));
-
-					count += len;
-
-					while (len)
-					{
-						*p = value;
-						p += sizeof(byteValue);
-						len--;
-					}
-				}
-				else if (128 == len)
-				{
-					// Do nothing
-				}
-			}
+		case 1: colourPlanes = 1; break;
+		case 3: colourPlanes = 3; break;
+		default:
+			std::cout << "[ImageDataReader] Colour mode " << headerInfo.ColourMode << " not implemented" << std::endl;
+			return false;
 		}
-
-		unsigned char* source = dataImage;
-		auto* dest = new unsigned char[totalBytes];
-		memset(dest, 254, totalBytes);
-
-		for (int colour = 0; colour < headerInfo.Channels; ++colour)
+		if (headerInfo.Channels < colourPlanes) return false;
+
+		const bool hasAlpha = headerInfo.Channels > colourPlanes;
+		const int planeCount = colourPlanes + (hasAlpha ? 1 : 0);
+		const size_t sampleBytes = size_t(depth / 8);
+		const size_t pixels = size_t(headerInfo.Width) * size_t(headerInfo.Height);
+		const size_t planeBytes = pixels * sampleBytes;
+
+		util::BigEndianCursor cursor = file;
+		cursor.SeekOffset(combinedImage.Offset + 2);
+		std::vector<unsigned char> planar(planeBytes * planeCount);
+		if (!DecodePlanes(cursor, combinedImage, headerInfo, planeCount, planar.data(), parameters)) return false;
+
+		// Opaque when there is no transparency, 1.0f for 32-bit.
+		std::vector<unsigned char> opaque;
+		if (!hasAlpha)
 		{
-			int pixelCounter = colour * bytesPerPixelPerChannel;
-			for (int nPos = 0; nPos < pixels; ++nPos)
+			const unsigned char one[4] = { 0x3F, 0x80, 0x00, 0x00 };
+			opaque.resize(planeBytes, 0xFF);
+			for (size_t i = 0; depth == 32 && i < planeBytes; i += 4)
 			{
-				memcpy(dest + pixelCounter, source, bytesPerPixelPerChannel);
-				source++;
-
-				pixelCounter += headerInfo.Channels*bytesPerPixelPerChannel;
+				memcpy(opaque.data() + i, one, 4);
 			}
 		}
 
-		delete[] dataImage;
-		dataImage = dest;
-
-		if (dataImage)
+		const unsigned char* colour = planar.data();
+		const unsigned char* planes[4] =
 		{
-			//const auto nHorResolution = int(resInfo.HRes);
-			//const auto nVertResolution = int(resInfo.VRes);
-			//int ppmX = (nHorResolution * 10000) / 254;
-			//int ppmY = (nVertResolution * 10000) / 254;
-
-			switch (headerInfo.BitsPerPixel)
-			{
-			case 1:
-			{
-				std::cout << "Not implemented" << std::endl; // Not implemented
-			}
-			break;
-
-			case 8:
-			case 16:
+			colour,
+			colourPlanes == 3 ? colour + planeBytes : colour,
+			colourPlanes == 3 ? colour + 2 * planeBytes : colour,
+			hasAlpha ? colour + colourPlanes * planeBytes : opaque.data()
+		};
+
+		// Interleaved by bands of rows on the workers.
+		combinedImage.Rgba.resize(pixels * 4 * sampleBytes);
+		const size_t width = size_t(headerInfo.Width);
+		const size_t bandRows = 64;
+		const size_t bands = (size_t(headerInfo.Height) + bandRows - 1) / bandRows;
+		util::Parallel::For(bands, parameters.ThreadCount, [&](size_t band)
+		{
+			parameters.Cancellation.ThrowIfCancelled();
+			const size_t first = band * bandRows * width;
+			const size_t count = std::min(pixels - first, bandRows * width);
+			const unsigned char* bandPlanes[4];
+			for (int k = 0; k < 4; ++k)
 			{
-				//CreateDIBSection(nWidth, nHeight, ppm_x, ppm_y, 24);
-				//break;
+				bandPlanes[k] = planes[k] + first * sampleBytes;
 			}
-			break;
-
-			default: ;
-			}
-		}
-
-		delete[] dataImage;
-		dataImage = nullptr;
+			ChannelDecoder::Interleave(bandPlanes, combinedImage.Rgba.data() + first * 4 * sampleBytes, count, int(sampleBytes));
+		});
+		return true;
 	}
 
-
 	//----------------------------------------------------------------------------------------
-	void ImageDataReader::RawDataReader(FILE* file, ImageData& combinedImage, ResolutionInfo const& resInfo, HeaderData const& headerInfo)
+	bool ImageDataReader::DecodePlanes(util::BigEndianCursor& cursor, ImageData const& combinedImage, HeaderData const& headerInfo, int planeCount, unsigned char* planar, ReaderParameters const& parameters)
 	{
-		const int width = headerInfo.Width;
-		const int height = headerInfo.Height;
-		const int bytesPerPixelPerChannel = headerInfo.BitsPerPixel / 8;
-
-		const int pixels = width * height;
-		int totalBytes = pixels * bytesPerPixelPerChannel * headerInfo.Channels;
-
-		unsigned char* proccessBuffer = nullptr;
-		unsigned char* dataImage;
+		const size_t rows = size_t(headerInfo.Height);
+		const size_t rowBytes = size_t(headerInfo.Width) * (headerInfo.BitsPerPixel / 8);
+		const size_t planeBytes = rows * rowBytes;
 
-		int bytesRead = 0;
-		switch (headerInfo.ColourMode)
+		switch (combinedImage.Compression)
 		{
-		case 1:		// Grayscale
-		case 8:		// Duotone
+		// -------------- RAW ------------------
+		case 0:
 		{
-			proccessBuffer = new unsigned char[totalBytes];
-			dataImage = new unsigned char[bytesPerPixelPerChannel];
-			memset(proccessBuffer, 254, totalBytes);
-			memset(dataImage, 254, bytesPerPixelPerChannel);
-
-			while (!feof(file) && (bytesRead < totalBytes))
+			// Copied by bands of rows to stay cancellable on huge documents.
+			const size_t totalRows = rows * planeCount;
+			const size_t bandRows = 1024;
+			for (size_t row = 0; row < totalRows; row += bandRows)
 			{
-				memset(dataImage, 254, bytesPerPixelPerChannel);
-				fread(dataImage, bytesPerPixelPerChannel, 1, file);
-				memcpy(proccessBuffer + bytesRead, dataImage, bytesPerPixelPerChannel);
-				bytesRead += bytesPerPixelPerChannel;
+				parameters.Cancellation.ThrowIfCancelled();
+				cursor.ReadBytes(planar + row * rowBytes, std::min(bandRows, totalRows - row) * rowBytes);
 			}
-
-			delete[] dataImage;
-			dataImage = nullptr;
+			return true;
 		}
-		break;
-		case 2:		// Indexed
+		// ----------------- RLE ------------------
+		case 1:
 		{
-			proccessBuffer = new unsigned char[totalBytes];
-			dataImage = new unsigned char[bytesPerPixelPerChannel];
-			memset(proccessBuffer, 254, totalBytes);
-			memset(dataImage, 254, bytesPerPixelPerChannel);
-
-			while (!feof(file) && (bytesRead < totalBytes))
+			// The row sizes of every channel come first, then the rows of each channel.
+			std::vector<unsigned int> sizes(rows * headerInfo.Channels);
+			for (auto& size : sizes)
 			{
-				memset(dataImage, 254, bytesPerPixelPerChannel);
-				fread(dataImage, bytesPerPixelPerChannel, 1, file);
-				memcpy(proccessBuffer + bytesRead, dataImage, bytesPerPixelPerChannel);
-				bytesRead += bytesPerPixelPerChannel;
+				size = headerInfo.ReadRleRowSize(cursor);
 			}
 
-			delete[] dataImage;
-			dataImage = nullptr;
-		}
-		break;
-		case 3:		// RGB
-		{
-			int bytesToReadPerPixelPerChannel = bytesPerPixelPerChannel;
-			if (2 == bytesToReadPerPixelPerChannel)
-			{
-				bytesToReadPerPixelPerChannel = 1;
-				totalBytes = pixels * bytesToReadPerPixelPerChannel * headerInfo.Channels;
-			}
-
-			dataImage = new unsigned char[bytesToReadPerPixelPerChannel];
-			proccessBuffer = new unsigned char[totalBytes];
-			memset(proccessBuffer, 254, totalBytes);
-			memset(dataImage, 254, bytesToReadPerPixelPerChannel);
-
-			for (int nColour = 0; nColour < 3; ++nColour)
+			std::vector<size_t> starts(planeCount + 1, 0);
+			for (int plane = 0; plane < planeCount; ++plane)
 			{
-				int pixelCounter = nColour;
-				for (int nPos = 0; nPos < pixels; ++nPos)
+				starts[plane + 1] = starts[plane];
+				for (size_t row = 0; row < rows; ++row)
 				{
-					if (!feof(file)) continue;
-					
-					fread(dataImage, bytesToReadPerPixelPerChannel, 1, file);
-					memcpy(proccessBuffer + pixelCounter, dataImage, bytesToReadPerPixelPerChannel);
-					bytesRead += bytesToReadPerPixelPerChannel;
-					pixelCounter += 3;
-
-					if (2 == bytesPerPixelPerChannel) continue;
-
-					fread(dataImage, bytesToReadPerPixelPerChannel, 1, file);
+					starts[plane + 1] += sizes[plane * rows + row];
 				}
 			}
 
-			delete[] dataImage;
-			dataImage = nullptr;
-		}
-		break;
-		case 4:	// CMYK
-		{
-			dataImage = new unsigned char[bytesPerPixelPerChannel];
-			proccessBuffer = new unsigned char[totalBytes];
-			memset(proccessBuffer, 254, totalBytes);
-			memset(dataImage, 254, bytesPerPixelPerChannel);
-
-			for (int nColour = 0; nColour < headerInfo.Channels; ++nColour)
+			const size_t available = std::min(cursor.Remaining(), starts[planeCount]);
+			const unsigned char* data = cursor.Take(available);
+			std::atomic<bool> corrupted(false);
+			util::Parallel::For(size_t(planeCount), parameters.ThreadCount, [&](size_t plane)
 			{
-				int pixelCounter = nColour * bytesPerPixelPerChannel;
-				for (int nPos = 0; nPos < pixels; ++nPos)
+				const std::vector<unsigned int> planeSizes(sizes.begin() + plane * rows, sizes.begin() + (plane + 1) * rows);
+				const size_t start = std::min(starts[plane], available);
+				if (!ChannelDecoder::DecodeRle(data + start, available - start, planeSizes, planar + plane * planeBytes, rowBytes, &parameters.Cancellation))
 				{
-					if (!feof(file))
-					{
-						fread(dataImage, bytesPerPixelPerChannel, 1, file);
-						memcpy(proccessBuffer + pixelCounter, dataImage, bytesPerPixelPerChannel);
-						bytesRead += bytesPerPixelPerChannel;
-
-						pixelCounter += headerInfo.Channels*bytesPerPixelPerChannel;
-					}
+					corrupted = true;
 				}
-			}
-
-			delete[] dataImage;
-			dataImage = nullptr;
-		}
-		break;
-		case 9:	// Lab
-		{
-			dataImage = new unsigned char[bytesPerPixelPerChannel];
-			proccessBuffer = new unsigned char[totalBytes];
-			memset(proccessBuffer, 254, totalBytes);
-			memset(dataImage, 254, bytesPerPixelPerChannel);
+			});
 
-			for (int colour = 0; colour < 3; ++colour)
+			if (corrupted)
 			{
-				int pixelCounter = colour * bytesPerPixelPerChannel;
-				for (int pos = 0; pos < pixels; ++pos)
-				{
-					if (!feof(file))
-					{
-						fread(dataImage, bytesPerPixelPerChannel, 1, file);
-						memcpy(proccessBuffer + pixelCounter, dataImage, bytesPerPixelPerChannel);
-						bytesRead += bytesPerPixelPerChannel;
-						pixelCounter += 3 * bytesPerPixelPerChannel;
-					}
-				}
+				std::cout << "[ImageDataReader] Corrupted RLE data" << std::endl;
 			}
-
-			delete[] dataImage;
-			dataImage = nullptr;
+			return true;
 		}
-		break;
-
-		default: ;
+		// -------  ZIP without prediction --------
+		// ---------  ZIP with prediction ---------
+		case 2:
+		case 3:
+		{
+			// One stream for all the channels, inflated whole. The extra channels past the
+			// transparency go to a scratch buffer and only the planes used are kept.
+			parameters.Cancellation.ThrowIfCancelled();
+			const size_t count = cursor.Remaining();
+			const size_t usedBytes = planeBytes * planeCount;
+			const size_t streamBytes = planeBytes * size_t(headerInfo.Channels);
+			std::vector<unsigned char> scratch(streamBytes > usedBytes ? streamBytes : 0);
+			unsigned char* destination = scratch.empty() ? planar : scratch.data();
+			if (!Inflater::Default().Inflate(cursor.Take(count), count, destination, streamBytes)) return false;
+			if (!scratch.empty()) memcpy(planar, scratch.data(), usedBytes);
+
+			if (combinedImage.Compression == 3)
+			{
+				ChannelDecoder::UndoPrediction(planar, rows * planeCount, size_t(headerInfo.Width), headerInfo.BitsPerPixel);
+			}
+			return true;
 		}
-
-		if (bytesRead == totalBytes && proccessBuffer != nullptr)
-		{		
-			//int nHorResolution = int(resInfo.HRes);
-			//int nVertResolution = int(resInfo.VRes);
-			//int ppm_x = (nHorResolution * 10000) / 254;
-			//int ppm_y = (nVertResolution * 10000) / 254;
-
-			switch (headerInfo.BitsPerPixel)
-			{
-			case 1:
-			{
-				// Not yet implemented
-			}
-			break;
-			case 8:
-			case 16:
-			{
-				// CreateDIBSection(nWidth, nHeight, ppm_x, ppm_y, 24);
-				//break;
-			}
-			break;
-			default:
-			{
-				// Unsupported format
-			}
-			}
-
-			/*HBITMAP hBitmap = mhBitmap;
-
-			if (!hBitmap)
-			{
-				delete[] ProccessBuffer;
-				ProccessBuffer = 0;
-
-				delete[] dataImage;
-				dataImage = 0;
-
-				nErrorCode = -9;	// Cannot create hBitmap
-				return nErrorCode;
-			}
-			ProccessBuffer(ProccessBuffer);*/			
+		default:
+			return false;
 		}
-
-		delete[] proccessBuffer;
-		proccessBuffer = nullptr;
 	}
 }
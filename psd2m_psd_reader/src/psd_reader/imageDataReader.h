@@ -17,21 +17,27 @@
 #ifndef IMAGEDATAREADER_H
 #define IMAGEDATAREADER_H
 
+#include <vector>
 #include "imageResourceReader.h"
 #include "headerReader.h"
+#include "layerAndMaskReader.h"
 using namespace util;
 namespace psd_reader
 {
 #pragma region DATA
 
 	//----------------------------------------------------------------------------------------------
+	// Merged image of the document, as saved with maximize compatibility.
 	struct ImageData
 	{
-		unsigned char* Data;
+		unsigned long long Offset = 0; // Position in the file of the section, compression value included. 0 if missing.
+		short Compression = -1; // 0 raw, 1 RLE, 2 ZIP, 3 ZIP with prediction.
+		int Width = 0;
+		int Height = 0;
+		short BitsPerPixel = 0;
 
-		ImageData();;
-
-		~ImageData();;
+		// Interleaved RGBA, each sample of BitsPerPixel big-endian as in the channels. Empty until decoded.
+		std::vector<unsigned char> Rgba;
 	};
 
 #pragma endregion
@@ -42,11 +48,14 @@ namespace psd_reader
 	class ImageDataReader
 	{
 	public:
-		static bool Read(FILE* file, ImageData& combinedImage, ResolutionInfo const& resInfo, HeaderData const& headerInfo);
+		// Locate the section, the pixels are left to Decode.
+		static bool Read(util::BigEndianCursor& cursor, ImageData& combinedImage, HeaderData const& headerInfo);
+
+		// Decode the RGB or grayscale merged image, file being a cursor on the image data section.
+		static bool Decode(util::BigEndianCursor const& file, ImageData& combinedImage, HeaderData const& headerInfo, ReaderParameters const& parameters);
 
 	private:
-		static void RleCompressionReader(FILE* file, ImageData & combinedImage, ResolutionInfo const& resInfo, HeaderData const& headerInfo);
-		static void RawDataReader(FILE* file, ImageData & combinedImage, ResolutionInfo const& resInfo, HeaderData const& headerInfo);
+		static bool DecodePlanes(util::BigEndianCursor& cursor, ImageData const& combinedImage, HeaderData const& headerInfo, int planeCount, unsigned char* planar, ReaderParameters const& parameters);
 	};
 
 #pragma endregion
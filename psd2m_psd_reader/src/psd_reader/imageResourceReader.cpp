@@ -14,170 +14,84 @@
 //
 //----------------------------------------------------------------------------------------------
 
-#include <cassert>
-#include <bitset>
 #include "imageResourceReader.h"
-#include "util/utils.h"
+#include "jpegDecoder.h"
 #include <algorithm>
+#include <utility>
 
 namespace psd_reader
 {
-	typedef unsigned char BYTE;
-
-	//----------------------------------------------------------------------------------------
-	static float BitValue(const char& val, int index)
-	{
-		return (val & (1 << index)) ? 1.0f : 0.0f;
-	}
-
 	//----------------------------------------------------------------------------------------
-	float ImageResourceReader::fixedPoint(const unsigned char*  value, bool checkSign, int size, int positionPoint)
+	bool ImageResourceReader::Read(BigEndianCursor& cursor, ImageResourceData& imageResource)
 	{
-		float res    = 0.f;
-		float sign = BitValue(value[0], 7);
-		int exposant = positionPoint - 5; // 3 bits guard
-
-		for (int i = 4; i < size; i++)
-		{
-			float bit = BitValue(value[i / 8], 7 - (i % 8));
-			float power = float(pow(2, exposant));
-			res += (bit * power);
-			exposant--;
-		}
-		if(checkSign)
-		{
-			int signe = int(BitValue(value[0], 7));
-			res = res - (16.0f * sign);
-		}
-		return res;
-	}
-
-	//----------------------------------------------------------------------------------------
-	bool ImageResourceReader::Read(FILE* file, ImageResourceData& imageResource)
-	{
-		const bool success = false;
-
 		// Get length
-		unsigned char length[4];
-		fread(&length, sizeof(length), 1, file);
-		imageResource.Length = util::Utils::Calculate(length, sizeof(imageResource.Length));
-
-		// start the reading
-		int bytesRead = 0;
-		const int totalBytes = imageResource.Length;
+		imageResource.Length = cursor.Read<int>();
+		BigEndianCursor section = cursor.Sub(imageResource.Length);
 
-		while (!feof(file) && (bytesRead < totalBytes))
+		while (!section.AtEnd())
 		{
-			if (!ReadResourceBlocks(file, imageResource, bytesRead)) return success;
+			if (!ReadResourceBlocks(section, imageResource)) return false;
 		}
-		return (bytesRead == totalBytes);
+		imageResource.BuildIndex();
+		return true;
 	}
 
 	//----------------------------------------------------------------------------------------
-	bool ImageResourceReader::ReadResourceBlocks(FILE* file, ImageResourceData& imageResource, int& bytesRead)
+	bool ImageResourceReader::ReadResourceBlocks(BigEndianCursor& cursor, ImageResourceData& imageResource)
 	{
-		char osType[4];
-		char* name = nullptr;
-		bool success = false;
-
-	
 		// Read OSType
-		fread(&osType, sizeof(osType), 1, file);
-		bytesRead += sizeof(osType);
-		assert(0 == (bytesRead % 2));
+		const std::string osType = cursor.ReadKey();
 
 		// Read resource ID
-		unsigned char ID[2];
-		fread(&ID, sizeof(ID), 1, file);
-		bytesRead += sizeof(ID);
-		short id = (short)util::Utils::Calculate(ID, sizeof(ID));
-
-		// Read Name
-		unsigned char sizeReaded;
-		fread(&sizeReaded, sizeof(sizeReaded), 1, file);
-		bytesRead += sizeof(sizeReaded);
+		const short id = cursor.Read<short>();
 
 		// Pascal string, padded to make the size even (a null name consists of two bytes of 0)
-		int elementSize = util::Utils::Calculate(&sizeReaded, sizeof(sizeReaded));
-		if( 0 < elementSize)
-		{ 
-			name = new char[elementSize];
-			fread(name, elementSize, 1, file);
-			bytesRead += sizeof(char) * elementSize;
-		}
+		std::string name = cursor.ReadPascalString(2);
 
-		if(0 == (elementSize % 2))
-		{
-			fread(&sizeReaded, sizeof(sizeReaded), 1, file);
-			bytesRead += sizeof(unsigned char);
-		}
-	
-		// Read size
-		unsigned char Size[4];
-		fread(&Size, sizeof(Size), 1, file);
-		bytesRead += sizeof(Size);
-		int size = util::Utils::Calculate(Size, sizeof(size));
+		// Read size, the data is padded to make the size even
+		const unsigned int size = cursor.Read<unsigned int>();
+		BigEndianCursor block = cursor.Sub(size);
+		cursor.Skip(size % 2);
 		if (size == 0) return true;
-		size += size % 2;
 
 		// Continue if OSType == "8BIM"
-		if (!util::Utils::CheckSignature(osType, "8BIM")) return success;
-		
-		// Read the specific Image Resource IDs
+		if (osType != "8BIM") return false;
+
+		// Read the specific Image Resource IDs, any other block is skipped
 		if (id >= 2000 && id <= 2997 /*|| id == 2999 || id == 1025*/)
 		{
 			ResourceBlockPath resourcebp;
-			std::string vectorName = std::string(name, elementSize);
-			std::replace(vectorName.begin(), vectorName.end(), ' ', '_');
-			resourcebp.Name = vectorName;
-			ReadPaths(file, resourcebp, size, bytesRead);
+			std::replace(name.begin(), name.end(), ' ', '_');
+			resourcebp.Name = name;
+			ReadPaths(block, resourcebp);
 			imageResource.ResourceBlockPaths.push_back(resourcebp);
 		}
 		else if (id == 1005)
 		{
-			ReadResolutionInfo(file, imageResource, bytesRead);
+			ReadResolutionInfo(block, imageResource);
 		}
-		else
+		else if (id == 1036 || (id == 1033 && imageResource.Thumbnail.Rgba.empty()))
 		{
-			unsigned char c[1];
-			for (int n = 0; n < size; ++n)
-			{
-				fread(&c, sizeof(c), 1, file);
-				bytesRead += sizeof(c);
-			}
+			ReadThumbnail(block, imageResource, id == 1033);
 		}
 		return true;
 	}
 
 	//----------------------------------------------------------------------------------------
-	bool ImageResourceReader::ReadPaths(FILE* file, ResourceBlockPath & resourceBlockPath, int sizeBlock, int& bytesRead)
+	bool ImageResourceReader::ReadPaths(BigEndianCursor& cursor, ResourceBlockPath & resourceBlockPath)
 	{
-		unsigned char selectorData[2];
-		const int size = sizeBlock / 26;
-
-		PathRecord pathRecord;
+		const size_t size = cursor.Size() / 26;
 
-		for (int i = 0; i < size; i++)
+		for (size_t i = 0; i < size; i++)
 		{
-			fread(selectorData, sizeof(selectorData), 1, file);
-			bytesRead += sizeof(selectorData);
-			const auto selector = short(Utils::Calculate(selectorData, sizeof(selectorData)));
+			const auto selector = cursor.Read<short>();
 			switch (selector)
 			{
 			case 0:
 			case 3:
 			{
-				if (!pathRecord.Points.empty() && !(pathRecord.IsClosedPath && pathRecord.Points.size() <= 2))
-				{
-					resourceBlockPath.PathRecords.push_back(pathRecord);
-				}
-
-				pathRecord = PathRecord();
-				pathRecord.IsClosedPath = (selector == 0);
-
-				unsigned char pathRecordData[24];
-				fread(pathRecordData, sizeof(pathRecordData), 1, file);
-				bytesRead += sizeof(pathRecordData);
+				resourceBlockPath.PathRecords.BeginPath(selector == 0);
+				cursor.Skip(24);
 				break;
 			}
 			case 1:
@@ -185,78 +99,74 @@ namespace psd_reader
 			case 2:
 			case 5:
 			{
-				PathPoints* points = ReadPathPoint(file, bytesRead);
-				points->IsLinked = (selector == 1 || selector == 4);
-				pathRecord.Points.push_back(points);
+				PathPoints points = ReadPathPoint(cursor);
+				points.IsLinked = (selector == 1 || selector == 4);
+				resourceBlockPath.PathRecords.AddPoint(points);
 				break;
 			}
 			default:
 			{
-				unsigned char pathRecordData[24];
-				fread(pathRecordData, sizeof(pathRecordData), 1, file);
-				bytesRead += sizeof(pathRecordData);
+				cursor.Skip(24);
 				break;
 			}
 			}
 		}
-		if (!pathRecord.Points.empty() && !(pathRecord.IsClosedPath && pathRecord.Points.size() <= 2))
-		{
-			resourceBlockPath.PathRecords.push_back(pathRecord);
-		}
+		resourceBlockPath.PathRecords.EndPath();
 		return true;
 	}
 
 	//----------------------------------------------------------------------------------------
-	bool ImageResourceReader::ReadResolutionInfo(FILE* file, ImageResourceData & imageResource, int& bytesRead)
+	bool ImageResourceReader::ReadResolutionInfo(BigEndianCursor& cursor, ImageResourceData & imageResource)
 	{
-		unsigned char intValue[4];
-		unsigned char shortValue[2];
-
-		fread(&shortValue, sizeof(shortValue), 1, file);
-		bytesRead += sizeof(shortValue);
-		imageResource.ResolutionInfo.HRes = short(Utils::Calculate(shortValue, sizeof(imageResource.ResolutionInfo.HRes)));
+		// Resolutions are 16.16 fixed point, only the integer part is kept.
+		imageResource.ResolutionInfo.HRes = cursor.Read<short>();
+		cursor.Skip(2);
+		imageResource.ResolutionInfo.HResUnit = cursor.Read<short>();
+		imageResource.ResolutionInfo.WidthUnit = cursor.Read<short>();
 
-		fread(&intValue, sizeof(intValue), 1, file);
-		bytesRead += sizeof(intValue);
-		imageResource.ResolutionInfo.HResUnit = Utils::Calculate(intValue, sizeof(imageResource.ResolutionInfo.HResUnit));
-
-		fread(&shortValue, sizeof(shortValue), 1, file);
-		bytesRead += sizeof(shortValue);
-		imageResource.ResolutionInfo.WidthUnit = short(Utils::Calculate(shortValue, sizeof(imageResource.ResolutionInfo.WidthUnit)));
-
-		fread(&shortValue, sizeof(shortValue), 1, file);
-		bytesRead += sizeof(shortValue);
-		imageResource.ResolutionInfo.VRes = short(Utils::Calculate(shortValue, sizeof(imageResource.ResolutionInfo.VRes)));
-
-		fread(&intValue, sizeof(intValue), 1, file);
-		bytesRead += sizeof(intValue);
-		imageResource.ResolutionInfo.VResUnit = Utils::Calculate(intValue, sizeof(imageResource.ResolutionInfo.VResUnit));
-
-		fread(&shortValue, sizeof(shortValue), 1, file);
-		bytesRead += sizeof(shortValue);
-		imageResource.ResolutionInfo.HeightUnit = short(Utils::Calculate(shortValue, sizeof(imageResource.ResolutionInfo.HeightUnit)));
+		imageResource.ResolutionInfo.VRes = cursor.Read<short>();
+		cursor.Skip(2);
+		imageResource.ResolutionInfo.VResUnit = cursor.Read<short>();
+		imageResource.ResolutionInfo.HeightUnit = cursor.Read<short>();
 
 		return true;
 	}
 
 	//----------------------------------------------------------------------------------------
-	PathPoints* ImageResourceReader::ReadPathPoint(FILE * file, int & bytesRead)
+	bool ImageResourceReader::ReadThumbnail(BigEndianCursor& cursor, ImageResourceData& imageResource, bool isBgr)
 	{
-		
-		unsigned char pathRecordData[24];
-		PathPoints* pathPoints = new PathPoints();
+		// Format (1 = JFIF), width, height, row bytes, total size, compressed size, bits per pixel
+		// and planes come before the JFIF data. The sizes are taken from the JFIF itself.
+		const int format = cursor.Read<int>();
+		cursor.Skip(24);
+		if (format != 1) return false;
+
+		ThumbnailData thumbnail;
+		const size_t size = cursor.Remaining();
+		if (!JpegDecoder::Decode(cursor.Take(size), size, thumbnail.Width, thumbnail.Height, thumbnail.Rgba)) return false;
+
+		// Photoshop 4 thumbnails are stored BGR.
+		for (size_t i = 0; isBgr && i < thumbnail.Rgba.size(); i += 4)
+		{
+			std::swap(thumbnail.Rgba[i], thumbnail.Rgba[i + 2]);
+		}
+		imageResource.Thumbnail = std::move(thumbnail);
+		return true;
+	}
 
-		fread(pathRecordData, sizeof(pathRecordData), 1, file);
-		bytesRead += sizeof(pathRecordData);
+	//----------------------------------------------------------------------------------------
+	PathPoints ImageResourceReader::ReadPathPoint(BigEndianCursor& cursor)
+	{
+		PathPoints pathPoints;
 
-		pathPoints->SegIn.y = fixedPoint(&pathRecordData[0], true, 32, 8);
-		pathPoints->SegIn.x = fixedPoint(&pathRecordData[4], true, 32, 8);
+		pathPoints.SegIn.y = cursor.ReadFixed8_24();
+		pathPoints.SegIn.x = cursor.ReadFixed8_24();
 
-		pathPoints->AnchorPoint.y = fixedPoint(&pathRecordData[8], true, 32, 8);
-		pathPoints->AnchorPoint.x = fixedPoint(&pathRecordData[12], true, 32, 8);
+		pathPoints.AnchorPoint.y = cursor.ReadFixed8_24();
+		pathPoints.AnchorPoint.x = cursor.ReadFixed8_24();
 
-		pathPoints->SegOut.y = fixedPoint(&pathRecordData[16], true, 32, 8);
-		pathPoints->SegOut.x = fixedPoint(&pathRecordData[20], true, 32, 8);
+		pathPoints.SegOut.y = cursor.ReadFixed8_24();
+		pathPoints.SegOut.x = cursor.ReadFixed8_24();
 
 		return pathPoints;
 	}
@@ -18,7 +18,9 @@
 #define IMAGERESOURCEREADER_H
 
 #include <vector>
+#include <unordered_map>
 #include "util/vectorialPath.h"
+#include "util/bigEndianCursor.h"
 using namespace util;
 
 namespace psd_reader
@@ -56,18 +58,25 @@ namespace psd_reader
 		}
 	};
 
-
+	//----------------------------------------------------------------------------------------------
+	// Preview saved by Photoshop in resource 1036 (1033 before Photoshop 5), decoded from JFIF.
+	struct ThumbnailData
+	{
+		int Width = 0;
+		int Height = 0;
+		std::vector<unsigned char> Rgba; // Width * Height * 4 bytes, empty when the file has no thumbnail.
+	};
 
 	//----------------------------------------------------------------------------------------------
 	struct ResourceBlockPath
 	{
 		std::string Name = "";
-		std::vector<PathRecord> PathRecords;
+		PathStore PathRecords;
 
 		ResourceBlockPath() = default;;
 		~ResourceBlockPath()
 		{
-			PathRecords.clear();
+			PathRecords.Clear();
 		};
 	};
 
@@ -76,7 +85,9 @@ namespace psd_reader
 	{
 		int Length;
 		ResolutionInfo ResolutionInfo;
+		ThumbnailData Thumbnail;
 		std::vector<ResourceBlockPath> ResourceBlockPaths;
+		std::unordered_map<std::string, size_t> PathIndex; // Position in ResourceBlockPaths by name, see BuildIndex.
 
 		ImageResourceData() : Length(0) { };
 
@@ -85,29 +96,27 @@ namespace psd_reader
 			ResourceBlockPaths.clear();
 		}
 
-		bool IsPathExist(std::string const& layerName) const
+		// Called by the readers once ResourceBlockPaths is complete, the first path of a name wins.
+		void BuildIndex()
 		{
-			for (auto resourceBlockPath : this->ResourceBlockPaths)
+			this->PathIndex.clear();
+			for (size_t i = 0; i < this->ResourceBlockPaths.size(); i++)
 			{
-				if (resourceBlockPath.Name.compare(layerName) == 0)
-				{
-					return true;
-				}
+				this->PathIndex.emplace(this->ResourceBlockPaths[i].Name, i);
 			}
-			return false;
 		}
 
-		ResourceBlockPath GetBlockPath(std::string const& layerName)
+		bool IsPathExist(std::string const& layerName) const
 		{
-			for (auto resourceBlockPath : this->ResourceBlockPaths)
-			{
-				if (resourceBlockPath.Name.compare(layerName) == 0)
-				{
-					return resourceBlockPath;
-				}
-			}
+			return this->PathIndex.find(layerName) != this->PathIndex.end();
+		}
 
-			return ResourceBlockPath();
+		// A path without name when none matches.
+		ResourceBlockPath const& GetBlockPath(std::string const& layerName) const
+		{
+			static const ResourceBlockPath noPath;
+			const auto found = this->PathIndex.find(layerName);
+			return found != this->PathIndex.end() ? this->ResourceBlockPaths[found->second] : noPath;
 		}
 	};
 
@@ -121,14 +130,14 @@ namespace psd_reader
 	public:
 		ImageResourceReader() = default;;
 		~ImageResourceReader() = default;;
-		static float fixedPoint(const unsigned char* value, bool checkSigne, int size, int positionPoint);
-		static bool Read(FILE* file, ImageResourceData& imageResource);
+		static bool Read(util::BigEndianCursor& cursor, ImageResourceData& imageResource);
 
 	private:
-		static bool ReadResourceBlocks(FILE* file, ImageResourceData& imageResource, int& bytesRead);
-		static bool ReadPaths(FILE* file, ResourceBlockPath & resourceBlockPath, int sizeBlock, int& bytesRead);
-		static bool ReadResolutionInfo(FILE* file, ImageResourceData& imageResource, int& bytesRead);
-		static util::PathPoints* ReadPathPoint(FILE* file, int& bytesRead);
+		static bool ReadResourceBlocks(util::BigEndianCursor& cursor, ImageResourceData& imageResource);
+		static bool ReadPaths(util::BigEndianCursor& cursor, ResourceBlockPath & resourceBlockPath);
+		static bool ReadResolutionInfo(util::BigEndianCursor& cursor, ImageResourceData& imageResource);
+		static bool ReadThumbnail(util::BigEndianCursor& cursor, ImageResourceData& imageResource, bool isBgr);
+		static util::PathPoints ReadPathPoint(util::BigEndianCursor& cursor);
 	};
 
 #pragma endregion
@@ -0,0 +1,97 @@
+//----------------------------------------------------------------------------------------------
+// ===============================================
+//  Copyright (C) 2026, E.D. Films.
+//  All Rights Reserved.
+// ===============================================
+//  Unauthorized copying of this file, via any medium is strictly prohibited
+//  Proprietary and confidential
+//
+//  @file inflater.cpp
+//  @author Michaelson Britt
+//  @date 16-10-2026
+//
+//  @section DESCRIPTION
+//
+//----------------------------------------------------------------------------------------------
+
+#include "inflater.h"
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <memory>
+#include "zlib.h"
+
+#ifdef PSD_READER_USE_LIBDEFLATE
+#include "libdeflate.h"
+#endif
+
+namespace psd_reader
+{
+	//----------------------------------------------------------------------------------------
+	Inflater const& Inflater::Default()
+	{
+#ifdef PSD_READER_USE_LIBDEFLATE
+		static const LibdeflateInflater inflater;
+#else
+		static const ZlibInflater inflater;
+#endif
+		return inflater;
+	}
+
+	//----------------------------------------------------------------------------------------
+	bool ZlibInflater::Inflate(const unsigned char* source, size_t sourceLength, unsigned char* destination, size_t destinationLength) const
+	{
+		z_stream stream;
+		memset(&stream, 0, sizeof(z_stream));
+		stream.data_type = Z_BINARY;
+		if (inflateInit(&stream) != Z_OK) return false;
+
+		// zlib counts are 32 bits, PSB channels over 4 GB are given to it by slices.
+		size_t pendingIn = sourceLength;
+		size_t pendingOut = destinationLength;
+		stream.next_in = const_cast<Bytef*>(source);
+		stream.next_out = destination;
+
+		int state;
+		bool refill;
+		do
+		{
+			if (stream.avail_in == 0)
+			{
+				stream.avail_in = uInt(std::min<size_t>(pendingIn, UINT_MAX));
+				pendingIn -= stream.avail_in;
+			}
+			if (stream.avail_out == 0)
+			{
+				stream.avail_out = uInt(std::min<size_t>(pendingOut, UINT_MAX));
+				pendingOut -= stream.avail_out;
+			}
+			state = inflate(&stream, Z_FINISH);
+			refill = (stream.avail_in == 0 && pendingIn > 0) || (stream.avail_out == 0 && pendingOut > 0);
+		} while (state == Z_OK || (state == Z_BUF_ERROR && refill));
+
+		// The stream must end exactly with the buffer: ending early would leave the rest of the
+		// buffer undecoded, going on means the stream doesn't hold what the caller expects.
+		const bool filled = stream.avail_out == 0 && pendingOut == 0;
+		inflateEnd(&stream);
+		return state == Z_STREAM_END && filled;
+	}
+
+#ifdef PSD_READER_USE_LIBDEFLATE
+	//----------------------------------------------------------------------------------------
+	bool LibdeflateInflater::Inflate(const unsigned char* source, size_t sourceLength, unsigned char* destination, size_t destinationLength) const
+	{
+		struct Release
+		{
+			void operator()(libdeflate_decompressor* decompressor) const { libdeflate_free_decompressor(decompressor); }
+		};
+		thread_local std::unique_ptr<libdeflate_decompressor, Release> decompressor(libdeflate_alloc_decompressor());
+		if (decompressor == nullptr) return false;
+
+		size_t written = 0;
+		const auto result = libdeflate_zlib_decompress(decompressor.get(), source, sourceLength, destination, destinationLength, &written);
+		// INSUFFICIENT_SPACE can stop before a match that doesn't fit, the end of the buffer unwritten.
+		return result == LIBDEFLATE_SUCCESS && written == destinationLength;
+	}
+#endif
+}
@@ -0,0 +1,67 @@
+//----------------------------------------------------------------------------------------------
+// ===============================================
+//  Copyright (C) 2026, E.D. Films.
+//  All Rights Reserved.
+// ===============================================
+//  Unauthorized copying of this file, via any medium is strictly prohibited
+//  Proprietary and confidential
+//
+//  @file inflater.h
+//  @author Michaelson Britt
+//  @date 16-10-2026
+//
+//  @section DESCRIPTION
+//  Decompressors of the ZIP channels, the whole channel at once straight into its pixel buffer.
+//
+//----------------------------------------------------------------------------------------------
+
+#ifndef INFLATER_H
+#define INFLATER_H
+
+#include <cstddef>
+
+namespace psd_reader
+{
+#pragma region INFLATERS
+
+	//----------------------------------------------------------------------------------------------
+	class Inflater
+	{
+	public:
+		Inflater() = default;
+		virtual ~Inflater() = default;
+		Inflater(Inflater const&) = delete;
+		Inflater& operator=(Inflater const&) = delete;
+
+		// Decompress a zlib stream into exactly destinationLength bytes. Safe between threads.
+		// False when the stream ends before or goes on past destinationLength bytes.
+		virtual bool Inflate(const unsigned char* source, size_t sourceLength, unsigned char* destination, size_t destinationLength) const = 0;
+
+		// libdeflate when built with PSD_READER_USE_LIBDEFLATE, zlib otherwise.
+		static Inflater const& Default();
+	};
+
+	//----------------------------------------------------------------------------------------------
+	// One inflate call with Z_FINISH, the stream is released even on failure.
+	//----------------------------------------------------------------------------------------------
+	class ZlibInflater : public Inflater
+	{
+	public:
+		bool Inflate(const unsigned char* source, size_t sourceLength, unsigned char* destination, size_t destinationLength) const override;
+	};
+
+#ifdef PSD_READER_USE_LIBDEFLATE
+	//----------------------------------------------------------------------------------------------
+	// Whole buffer decompressor, one per thread since they keep state between calls.
+	//----------------------------------------------------------------------------------------------
+	class LibdeflateInflater : public Inflater
+	{
+	public:
+		bool Inflate(const unsigned char* source, size_t sourceLength, unsigned char* destination, size_t destinationLength) const override;
+	};
+#endif
+
+#pragma endregion
+}
+
+#endif // INFLATER_H
@@ -0,0 +1,549 @@
+//----------------------------------------------------------------------------------------------
+// ===============================================
+//  Copyright (C) 2026, E.D. Films.
+//  All Rights Reserved.
+// ===============================================
+//  Unauthorized copying of this file, via any medium is strictly prohibited
+//  Proprietary and confidential
+//
+//  @file jpegDecoder.cpp
+//  @author Michaelson Britt
+//  @date 16-10-2026
+//
+//  @section DESCRIPTION
+//
+//----------------------------------------------------------------------------------------------
+
+#include "jpegDecoder.h"
+#include "util/bigEndianCursor.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace psd_reader
+{
+	const size_t JpegDecoder::MAX_PIXELS = size_t(1) << 26;
+
+	namespace
+	{
+		// Position in the block of the n-th coefficient of the stream.
+		const int ZIGZAG[64] =
+		{
+			 0,  1,  8, 16,  9,  2,  3, 10, 17, 24, 32, 25, 18, 11,  4,  5,
+			12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13,  6,  7, 14, 21, 28,
+			35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+			58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63
+		};
+
+		//----------------------------------------------------------------------------------------
+		// Canonical Huffman codes, decoded one bit at a time: thumbnails are small.
+		struct HuffmanTable
+		{
+			bool Defined = false;
+			int MinCode[17] = {};
+			int MaxCode[17] = {};
+			int ValueIndex[17] = {};
+			std::vector<unsigned char> Values;
+
+			void Build(const unsigned char counts[16])
+			{
+				int code = 0;
+				int index = 0;
+				for (int length = 1; length <= 16; ++length)
+				{
+					this->ValueIndex[length] = index;
+					this->MinCode[length] = code;
+					code += counts[length - 1];
+					index += counts[length - 1];
+					this->MaxCode[length] = counts[length - 1] > 0 ? code - 1 : -1;
+					code <<= 1;
+				}
+				this->Defined = true;
+			}
+		};
+
+		//----------------------------------------------------------------------------------------
+		struct Component
+		{
+			int Id = 0;
+			int H = 1;
+			int V = 1;
+			int Quantization = 0;
+			int DcTable = 0;
+			int AcTable = 0;
+			int Prediction = 0;
+			int BlocksPerLine = 0;
+			int BlocksPerColumn = 0;
+			std::vector<unsigned char> Pixels; // BlocksPerLine * 8 samples per line.
+		};
+
+		//----------------------------------------------------------------------------------------
+		// Entropy coded bits, with the stuffed zero after 0xFF removed. Zeros are read past a marker.
+		class BitReader
+		{
+		public:
+			BitReader(const unsigned char* data, size_t size, size_t position) : Data(data), Size(size), Position(position) {}
+
+			int Bit()
+			{
+				if (this->Count == 0) Fill();
+				--this->Count;
+				return (this->Buffer >> this->Count) & 1;
+			}
+
+			int Bits(int count)
+			{
+				int value = 0;
+				for (int i = 0; i < count; ++i)
+				{
+					value = (value << 1) | Bit();
+				}
+				return value;
+			}
+
+			// Skip to the byte after the next RSTn marker.
+			void Restart()
+			{
+				this->Count = 0;
+				this->AtMarker = false;
+				while (this->Position + 1 < this->Size && !(this->Data[this->Position] == 0xFF && this->Data[this->Position + 1] >= 0xD0 && this->Data[this->Position + 1] <= 0xD7))
+				{
+					++this->Position;
+				}
+				this->Position = std::min(this->Position + 2, this->Size);
+			}
+
+			// First marker after the entropy coded data, other than a restart.
+			size_t End() const
+			{
+				size_t position = this->Position;
+				while (position + 1 < this->Size)
+				{
+					const unsigned char next = this->Data[position + 1];
+					if (this->Data[position] == 0xFF && next != 0x00 && next != 0xFF && !(next >= 0xD0 && next <= 0xD7)) return position;
+					++position;
+				}
+				return this->Size;
+			}
+
+		private:
+			void Fill()
+			{
+				this->Buffer = 0;
+				this->Count = 8;
+				if (this->AtMarker || this->Position >= this->Size)
+				{
+					this->AtMarker = true;
+					return;
+				}
+
+				const unsigned char byte = this->Data[this->Position];
+				if (byte == 0xFF)
+				{
+					if (this->Position + 1 >= this->Size || this->Data[this->Position + 1] != 0x00)
+					{
+						this->AtMarker = true;
+						return;
+					}
+					++this->Position;
+				}
+				++this->Position;
+				this->Buffer = byte;
+			}
+
+			const unsigned char* Data;
+			size_t Size;
+			size_t Position;
+			unsigned Buffer = 0;
+			int Count = 0;
+			bool AtMarker = false;
+		};
+
+		//----------------------------------------------------------------------------------------
+		int DecodeHuffman(HuffmanTable const& table, BitReader& bits)
+		{
+			int code = 0;
+			for (int length = 1; length <= 16; ++length)
+			{
+				code = (code << 1) | bits.Bit();
+				if (code <= table.MaxCode[length])
+				{
+					const size_t index = size_t(table.ValueIndex[length] + code - table.MinCode[length]);
+					return index < table.Values.size() ? table.Values[index] : -1;
+				}
+			}
+			return -1;
+		}
+
+		//----------------------------------------------------------------------------------------
+		int Extend(int value, int bits)
+		{
+			return value < (1 << (bits - 1)) ? value - (1 << bits) + 1 : value;
+		}
+
+		//----------------------------------------------------------------------------------------
+		// Separable float IDCT, level shifted and clamped to 8 bits.
+		void InverseDct(const int coefficients[64], unsigned char* destination, size_t stride)
+		{
+			struct CosineTable
+			{
+				float Value[8][8];
+				CosineTable()
+				{
+					const double pi = 3.14159265358979323846;
+					for (int x = 0; x < 8; ++x)
+					{
+						for (int u = 0; u < 8; ++u)
+						{
+							const double scale = u == 0 ? std::sqrt(0.5) : 1.0;
+							Value[x][u] = float(scale * std::cos((2 * x + 1) * u * pi / 16.0) / 2.0);
+						}
+					}
+				}
+			};
+			static const CosineTable cosine;
+
+			float rows[64];
+			for (int y = 0; y < 8; ++y)
+			{
+				for (int x = 0; x < 8; ++x)
+				{
+					float sum = 0.0f;
+					for (int u = 0; u < 8; ++u)
+					{
+						sum += cosine.Value[x][u] * float(coefficients[y * 8 + u]);
+					}
+					rows[y * 8 + x] = sum;
+				}
+			}
+
+			for (int x = 0; x < 8; ++x)
+			{
+				for (int y = 0; y < 8; ++y)
+				{
+					float sum = 128.0f;
+					for (int v = 0; v < 8; ++v)
+					{
+						sum += cosine.Value[y][v] * rows[v * 8 + x];
+					}
+					destination[y * stride + x] = static_cast<unsigned char>(std::min(255.0f, std::max(0.0f, std::round(sum))));
+				}
+			}
+		}
+
+		//----------------------------------------------------------------------------------------
+		class JfifStream
+		{
+		public:
+			bool Decode(const unsigned char* data, size_t size, int& width, int& height, std::vector<unsigned char>& rgba)
+			{
+				util::BigEndianCursor cursor(data, size);
+				if (cursor.Read<unsigned short>() != 0xFFD8) return false;
+
+				bool scanned = false;
+				while (!cursor.AtEnd())
+				{
+					if (cursor.Read<unsigned char>() != 0xFF) return false;
+					unsigned char marker = cursor.Read<unsigned char>();
+					while (marker == 0xFF)
+					{
+						marker = cursor.Read<unsigned char>();
+					}
+
+					if (marker == 0xD9) break;
+					if (marker >= 0xD0 && marker <= 0xD7) continue;
+
+					const unsigned short length = cursor.Read<unsigned short>();
+					if (length < 2) return false;
+					util::BigEndianCursor segment = cursor.Sub(length - 2);
+
+					switch (marker)
+					{
+					case 0xDB:
+						if (!ReadQuantization(segment)) return false;
+						break;
+					case 0xC4:
+						if (!ReadHuffman(segment)) return false;
+						break;
+					case 0xC0:
+					case 0xC1:
+						if (!ReadFrame(segment)) return false;
+						break;
+					case 0xDD:
+						this->RestartInterval = segment.Read<unsigned short>();
+						break;
+					case 0xDA:
+					{
+						if (this->Components.empty() || !ReadScan(segment)) return false;
+						BitReader bits(data, size, cursor.Tell());
+						if (!DecodeScan(bits)) return false;
+						cursor.Seek(bits.End());
+						scanned = true;
+						break;
+					}
+					case 0xC2: case 0xC3: case 0xC5: case 0xC6: case 0xC7:
+					case 0xC9: case 0xCA: case 0xCB: case 0xCD: case 0xCE: case 0xCF:
+						// Progressive, lossless, hierarchical or arithmetic coded.
+						return false;
+					default:
+						// APPn, COM and the other segments don't change the pixels.
+						break;
+					}
+				}
+
+				if (!scanned) return false;
+				width = this->Width;
+				height = this->Height;
+				Convert(rgba);
+				return true;
+			}
+
+		private:
+			bool ReadQuantization(util::BigEndianCursor& segment)
+			{
+				while (!segment.AtEnd())
+				{
+					const unsigned char info = segment.Read<unsigned char>();
+					const int precision = info >> 4;
+					const int id = info & 15;
+					if (id > 3 || precision > 1) return false;
+					for (int k = 0; k < 64; ++k)
+					{
+						this->Quantization[id][k] = precision == 0 ? segment.Read<unsigned char>() : segment.Read<unsigned short>();
+					}
+				}
+				return true;
+			}
+
+			bool ReadHuffman(util::BigEndianCursor& segment)
+			{
+				while (!segment.AtEnd())
+				{
+					const unsigned char info = segment.Read<unsigned char>();
+					const int tableClass = info >> 4;
+					const int id = info & 15;
+					if (tableClass > 1 || id > 3) return false;
+
+					unsigned char counts[16];
+					segment.ReadBytes(counts, 16);
+					size_t total = 0;
+					for (unsigned char count : counts)
+					{
+						total += count;
+					}
+					if (total > 256) return false;
+
+					HuffmanTable& table = tableClass == 0 ? this->Dc[id] : this->Ac[id];
+					table.Values.resize(total);
+					if (total > 0) segment.ReadBytes(table.Values.data(), total);
+					table.Build(counts);
+				}
+				return true;
+			}
+
+			bool ReadFrame(util::BigEndianCursor& segment)
+			{
+				if (segment.Read<unsigned char>() != 8) return false;
+				this->MaxH = 1;
+				this->MaxV = 1;
+				this->Height = segment.Read<unsigned short>();
+				this->Width = segment.Read<unsigned short>();
+				const int count = segment.Read<unsigned char>();
+				if (this->Width == 0 || this->Height == 0 || (count != 1 && count != 3)) return false;
+				if (size_t(this->Width) * size_t(this->Height) > JpegDecoder::MAX_PIXELS) return false;
+
+				this->Components.assign(count, Component());
+				for (Component& component : this->Components)
+				{
+					component.Id = segment.Read<unsigned char>();
+					const unsigned char sampling = segment.Read<unsigned char>();
+					component.H = sampling >> 4;
+					component.V = sampling & 15;
+					component.Quantization = segment.Read<unsigned char>();
+					if (component.H < 1 || component.H > 4 || component.V < 1 || component.V > 4 || component.Quantization > 3) return false;
+					this->MaxH = std::max(this->MaxH, component.H);
+					this->MaxV = std::max(this->MaxV, component.V);
+				}
+
+				// Planes cover whole MCUs, the padding is cropped on conversion.
+				this->McusPerLine = (this->Width + 8 * this->MaxH - 1) / (8 * this->MaxH);
+				this->McusPerColumn = (this->Height + 8 * this->MaxV - 1) / (8 * this->MaxV);
+				for (Component& component : this->Components)
+				{
+					component.BlocksPerLine = this->McusPerLine * component.H;
+					component.BlocksPerColumn = this->McusPerColumn * component.V;
+					component.Pixels.assign(size_t(component.BlocksPerLine) * component.BlocksPerColumn * 64, 0);
+				}
+				return true;
+			}
+
+			bool ReadScan(util::BigEndianCursor& segment)
+			{
+				const int count = segment.Read<unsigned char>();
+				if (count < 1 || count > int(this->Components.size())) return false;
+
+				this->Scan.clear();
+				for (int i = 0; i < count; ++i)
+				{
+					const int id = segment.Read<unsigned char>();
+					const unsigned char tables = segment.Read<unsigned char>();
+					const auto found = std::find_if(this->Components.begin(), this->Components.end(), [id](Component const& component) { return component.Id == id; });
+					if (found == this->Components.end() || (tables >> 4) > 3 || (tables & 15) > 3) return false;
+
+					found->DcTable = tables >> 4;
+					found->AcTable = tables & 15;
+					found->Prediction = 0;
+					this->Scan.push_back(&*found);
+				}
+				// Spectral selection and successive approximation, fixed for sequential images.
+				segment.Skip(3);
+				return true;
+			}
+
+			bool DecodeBlock(Component& component, int blockRow, int blockColumn, BitReader& bits)
+			{
+				HuffmanTable const& dc = this->Dc[component.DcTable];
+				HuffmanTable const& ac = this->Ac[component.AcTable];
+				if (!dc.Defined || !ac.Defined) return false;
+				const int* quantization = this->Quantization[component.Quantization];
+
+				int coefficients[64] = {};
+				const int size = DecodeHuffman(dc, bits);
+				if (size < 0 || size > 15) return false;
+				component.Prediction += size > 0 ? Extend(bits.Bits(size), size) : 0;
+				coefficients[0] = component.Prediction * quantization[0];
+
+				for (int k = 1; k < 64;)
+				{
+					const int symbol = DecodeHuffman(ac, bits);
+					if (symbol < 0) return false;
+					const int run = symbol >> 4;
+					const int bitCount = symbol & 15;
+					if (bitCount == 0)
+					{
+						if (run != 15) break;
+						k += 16;
+						continue;
+					}
+
+					k += run;
+					if (k > 63) return false;
+					coefficients[ZIGZAG[k]] = Extend(bits.Bits(bitCount), bitCount) * quantization[k];
+					++k;
+				}
+
+				const size_t stride = size_t(component.BlocksPerLine) * 8;
+				InverseDct(coefficients, component.Pixels.data() + size_t(blockRow) * 8 * stride + size_t(blockColumn) * 8, stride);
+				return true;
+			}
+
+			bool DecodeScan(BitReader& bits)
+			{
+				// A single component scan isn't interleaved, its blocks only cover the component.
+				const bool interleaved = this->Scan.size() > 1;
+				Component& first = *this->Scan.front();
+				const int unitsPerLine = interleaved ? this->McusPerLine : ((this->Width * first.H + this->MaxH - 1) / this->MaxH + 7) / 8;
+				const int unitsPerColumn = interleaved ? this->McusPerColumn : ((this->Height * first.V + this->MaxV - 1) / this->MaxV + 7) / 8;
+				const int units = unitsPerLine * unitsPerColumn;
+
+				for (int unit = 0; unit < units; ++unit)
+				{
+					if (this->RestartInterval > 0 && unit > 0 && unit % this->RestartInterval == 0)
+					{
+						bits.Restart();
+						for (Component* component : this->Scan)
+						{
+							component->Prediction = 0;
+						}
+					}
+
+					const int row = unit / unitsPerLine;
+					const int column = unit % unitsPerLine;
+					if (!interleaved)
+					{
+						if (!DecodeBlock(first, row, column, bits)) return false;
+						continue;
+					}
+					for (Component* component : this->Scan)
+					{
+						for (int v = 0; v < component->V; ++v)
+						{
+							for (int h = 0; h < component->H; ++h)
+							{
+								if (!DecodeBlock(*component, row * component->V + v, column * component->H + h, bits)) return false;
+							}
+						}
+					}
+				}
+				return true;
+			}
+
+			unsigned char Sample(Component const& component, int x, int y) const
+			{
+				const size_t stride = size_t(component.BlocksPerLine) * 8;
+				return component.Pixels[size_t(y * component.V / this->MaxV) * stride + size_t(x * component.H / this->MaxH)];
+			}
+
+			// Upsampled to the full size, YCbCr to RGB as defined by JFIF.
+			void Convert(std::vector<unsigned char>& rgba) const
+			{
+				rgba.resize(size_t(this->Width) * size_t(this->Height) * 4);
+				unsigned char* out = rgba.data();
+				for (int y = 0; y < this->Height; ++y)
+				{
+					for (int x = 0; x < this->Width; ++x, out += 4)
+					{
+						if (this->Components.size() == 1)
+						{
+							out[0] = out[1] = out[2] = Sample(this->Components[0], x, y);
+						}
+						else
+						{
+							const float luma = Sample(this->Components[0], x, y);
+							const float cb = Sample(this->Components[1], x, y) - 128.0f;
+							const float cr = Sample(this->Components[2], x, y) - 128.0f;
+							out[0] = Clamp(luma + 1.402f * cr);
+							out[1] = Clamp(luma - 0.344136f * cb - 0.714136f * cr);
+							out[2] = Clamp(luma + 1.772f * cb);
+						}
+						out[3] = 255;
+					}
+				}
+			}
+
+			static unsigned char Clamp(float value)
+			{
+				return static_cast<unsigned char>(std::min(255.0f, std::max(0.0f, std::round(value))));
+			}
+
+			int Quantization[4][64] = {};
+			HuffmanTable Dc[4];
+			HuffmanTable Ac[4];
+			std::vector<Component> Components;
+			std::vector<Component*> Scan;
+			int Width = 0;
+			int Height = 0;
+			int MaxH = 1;
+			int MaxV = 1;
+			int McusPerLine = 0;
+			int McusPerColumn = 0;
+			int RestartInterval = 0;
+		};
+	}
+
+	//----------------------------------------------------------------------------------------
+	bool JpegDecoder::Decode(const unsigned char* data, size_t size, int& width, int& height, std::vector<unsigned char>& rgba)
+	{
+		if (data == nullptr) return false;
+		try
+		{
+			JfifStream stream;
+			return stream.Decode(data, size, width, height, rgba);
+		}
+		catch (std::out_of_range const&)
+		{
+			return false;
+		}
+	}
+}
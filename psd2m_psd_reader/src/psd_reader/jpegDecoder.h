@@ -0,0 +1,43 @@
+//----------------------------------------------------------------------------------------------
+// ===============================================
+//  Copyright (C) 2026, E.D. Films.
+//  All Rights Reserved.
+// ===============================================
+//  Unauthorized copying of this file, via any medium is strictly prohibited
+//  Proprietary and confidential
+//
+//  @file jpegDecoder.h
+//  @author Michaelson Britt
+//  @date 16-10-2026
+//
+//  @section DESCRIPTION
+//  Baseline JFIF decoding, enough for the thumbnails Photoshop embeds in the image resources.
+//
+//----------------------------------------------------------------------------------------------
+
+#ifndef JPEGDECODER_H
+#define JPEGDECODER_H
+
+#include <cstddef>
+#include <vector>
+
+namespace psd_reader
+{
+#pragma region DECODER
+
+	//----------------------------------------------------------------------------------------------
+	class JpegDecoder
+	{
+	public:
+		// Huffman baseline or extended sequential, 8-bit, gray or YCbCr with any sampling.
+		// Progressive, arithmetic and CMYK images are refused. rgba holds width * height * 4 bytes.
+		static bool Decode(const unsigned char* data, size_t size, int& width, int& height, std::vector<unsigned char>& rgba);
+
+		// Largest picture accepted, in pixels, corrupted sizes don't allocate gigabytes.
+		static const size_t MAX_PIXELS;
+	};
+
+#pragma endregion
+}
+
+#endif // JPEGDECODER_H
@@ -18,11 +18,14 @@
 #include <locale>
 
 #include "layerAndMaskReader.h"
-#include "util/utils.h"
-#include "imageResourceReader.h"
+#include "channelDecoder.h"
 #include <algorithm>
+#include <iterator>
 #include <functional>
-#include "zlib.h"
+#include <atomic>
+#include "inflater.h"
+#include "util/parallel.h"
+#include "util/contentHash.h"
 #include "headerReader.h"
 
 using namespace util;
@@ -51,75 +54,70 @@ namespace psd_reader
 	}
 
 	//----------------------------------------------------------------------------------------
-	static bool CheckSignatureLayerInfo(char* const signature)
+	static bool CheckSignatureLayerInfo(std::string const& signature)
 	{
-		const std::string strSignature(signature, 4);
-		return ("8BIM" == strSignature || "8B64" == strSignature);
+		return ("8BIM" == signature || "8B64" == signature);
 	}
 
 	//----------------------------------------------------------------------------------------
-	bool LayerAndMaskReader::Read(FILE* file, const HeaderData& headerData, LayerAndMaskData& layerMaskData, PsdProgress const& progress)	// Actually ignore it
+	// Length of an additional layer info block, on 8 bytes in a PSB for the keys holding pixels.
+	static unsigned long long ReadBlockLength(BigEndianCursor& cursor, const HeaderData& headerData, std::string const& key)
 	{
-		unsigned char dataLength[4];
-		int bytesRead = 0;
-
-		fread(&dataLength, sizeof(dataLength), 1, file);
-		bytesRead += sizeof(dataLength);
-		const int totalBytes = Utils::Calculate(dataLength, sizeof(dataLength));
-
-		ProcessLayerMaskInformation(file, bytesRead, headerData, layerMaskData, progress);
-		ReadHeaderAdditionalLayerGlobalInfo(file, bytesRead, headerData, layerMaskData, progress);
-
-		const int extradata = totalBytes - bytesRead;
-		if (extradata > 0)
+		static const std::string LARGE_KEYS[] = { "LMsk", "Lr16", "Lr32", "Layr", "Mt16", "Mt32", "Mtrn", "Alph", "FMsk", "lnk2", "FEid", "FXid", "PxSD" };
+		if (headerData.IsLargeDocument() && std::find(std::begin(LARGE_KEYS), std::end(LARGE_KEYS), key) != std::end(LARGE_KEYS))
 		{
-			const auto data = new unsigned char[extradata];
-			fread(data, sizeof(unsigned char) * extradata, 1, file);
-			bytesRead += (sizeof(unsigned char) * extradata);
+			return cursor.Read<unsigned long long>();
 		}
-
-		return (bytesRead == totalBytes);
+		return cursor.Read<unsigned int>();
 	}
 
-
 	//----------------------------------------------------------------------------------------
-	void LayerAndMaskReader::ProcessLayerMaskInformation(FILE* file, int& bytesRead, const HeaderData& headerData, LayerAndMaskData& layerMaskData, PsdProgress const& progress)
+	bool LayerAndMaskReader::Read(BigEndianCursor& cursor, const HeaderData& headerData, LayerAndMaskData& layerMaskData)
 	{
-		ReadLayerInfoSection(file, bytesRead, headerData,layerMaskData, progress);
-		ReadGlobalLayerMaskInfo(file, bytesRead, layerMaskData);
+		const unsigned long long totalBytes = headerData.ReadLength(cursor);
+		BigEndianCursor section = cursor.Sub(size_t(totalBytes));
+
+		ProcessLayerMaskInformation(section, headerData, layerMaskData);
+		ReadHeaderAdditionalLayerGlobalInfo(section, headerData, layerMaskData);
 
 		if (!layerMaskData.Layers.empty())
 		{
 			std::reverse(layerMaskData.Layers.begin(), layerMaskData.Layers.end());
 		}
+		layerMaskData.BuildIndex();
+		return true;
 	}
 
+
 	//----------------------------------------------------------------------------------------
-	bool LayerAndMaskReader::ReadLayerInfoSection(FILE* file, int& bytesRead, const HeaderData& headerData, LayerAndMaskData& layerMaskData, PsdProgress const& progress)
+	void LayerAndMaskReader::ProcessLayerMaskInformation(BigEndianCursor& cursor, const HeaderData& headerData, LayerAndMaskData& layerMaskData)
 	{
-		unsigned char dataLength[4];
-		unsigned char layerLength[2];
-		int bytesLayerinfoRead = 0;
-
-		fread(&dataLength, sizeof(dataLength), 1, file);
-		bytesRead += sizeof(dataLength);
-		int totalBytesLayer = Utils::Calculate(dataLength, sizeof(dataLength));
-		totalBytesLayer += totalBytesLayer % 2;
-
-		if (totalBytesLayer == 0) return true;
-
-		//Layer count. If it is a negative number, its absolute value is the number of layers and the first alpha channel contains the transparency data for the merged result.
-		fread(&layerLength, sizeof(layerLength), 1, file);
-		bytesLayerinfoRead += sizeof(layerLength);
-		// If it is a negative number, its absolute value is the number of layers and the first alpha channel contains the transparency data for the merged result.
-		const short layerCount = std::abs(short(Utils::Calculate(layerLength, sizeof(layerLength))));
+		// Length of the layers info section, rounded up to a multiple of 2.
+		const unsigned long long totalBytesLayer = headerData.ReadLength(cursor);
+		BigEndianCursor layerInfo = cursor.Sub(size_t(totalBytesLayer));
+		if (totalBytesLayer % 2 && !cursor.AtEnd()) cursor.Skip(1);
+
+		ReadLayerInfoSection(layerInfo, headerData, layerMaskData);
+		ReadGlobalLayerMaskInfo(cursor);
+	}
+
+	//----------------------------------------------------------------------------------------
+	bool LayerAndMaskReader::ReadLayerInfoSection(BigEndianCursor& cursor, const HeaderData& headerData, LayerAndMaskData& layerMaskData)
+	{
+		if (cursor.Size() == 0) return true;
+
+		// Layer count. If it is a negative number, its absolute value is the number of layers and the first alpha channel contains the transparency data for the merged result.
+		const short layerCount = std::abs(cursor.Read<short>());
 		layerMaskData.LayerCount = layerCount;
 
 		for (int i = 0; i < layerCount; i++)
 		{
 			LayerData currentlayer;
-			ReadLayerRecordsSection(file, bytesLayerinfoRead, currentlayer);
-			ReadLayerInfoSectionExtraDataField(file, bytesLayerinfoRead, currentlayer);
+			const unsigned char* record = cursor.Data();
+			if (!ReadLayerRecordsSection(cursor, headerData, currentlayer)) return false;
+			ReadLayerInfoSectionExtraDataField(cursor, headerData, currentlayer);
+			// Rectangle, channels, name and vector mask. HashChannels adds the channel bytes.
+			currentlayer.RecordHash = util::ContentHash::Of(record, size_t(cursor.Data() - record));
 			if(currentlayer.Type == TEXTURE_LAYER)
 			{
 				std::string layerName = LayerAndMaskData::LayerNameInfluenceAssociated(currentlayer.LayerName);
@@ -131,518 +129,504 @@ namespace psd_reader
 			layerMaskData.Layers.push_back(currentlayer);
 		}
 
-		ReadChannelImageData(file, bytesLayerinfoRead, headerData.BitsPerPixel, layerMaskData, progress);
-
-		// Read the extra size 
-		const int extradata = totalBytesLayer - bytesLayerinfoRead;
-		if (extradata > 0)
-		{
-			auto* data = new unsigned char[extradata];
-			fread(data, sizeof(unsigned char) * extradata, 1, file);
-			bytesLayerinfoRead += (sizeof(unsigned char) * extradata);
-		}
-
-		bytesRead += bytesLayerinfoRead;
-		return totalBytesLayer == bytesLayerinfoRead;
+		return ReadChannelImageData(cursor, layerMaskData);
 	}
 
 	//----------------------------------------------------------------------------------------
-	bool LayerAndMaskReader::ReadLayerRecordsSection(FILE* file, int& bytesRead, LayerData& layerData)
+	bool LayerAndMaskReader::ReadLayerRecordsSection(BigEndianCursor& cursor, const HeaderData& headerData, LayerData& layerData)
 	{
-		int tmpBytesRead = 0;
-
-		unsigned char dataLength[4];
-		unsigned char coordinateLayer[4];
-		unsigned char channelCount[2];
-
 		// Rectangle containing the contents of the layer. Specified as top, left, bottom, right coordinates
-		fread(&coordinateLayer, sizeof(coordinateLayer), 1, file); // Top
-		layerData.AnchorTop = Utils::Calculate(coordinateLayer, sizeof(coordinateLayer));
-
-		fread(&coordinateLayer, sizeof(coordinateLayer), 1, file); //Left
-		layerData.AnchorLeft = Utils::Calculate(coordinateLayer, sizeof(coordinateLayer));
-
-		fread(&coordinateLayer, sizeof(coordinateLayer), 1, file); // Bottom
-		layerData.AnchorBottom = Utils::Calculate(coordinateLayer, sizeof(coordinateLayer));
-
-		fread(&coordinateLayer, sizeof(coordinateLayer), 1, file); // Right
-		layerData.AnchorRight = Utils::Calculate(coordinateLayer, sizeof(coordinateLayer));
-
-		tmpBytesRead += (sizeof(coordinateLayer) * 4);
+		layerData.AnchorTop = cursor.Read<int>();
+		layerData.AnchorLeft = cursor.Read<int>();
+		layerData.AnchorBottom = cursor.Read<int>();
+		layerData.AnchorRight = cursor.Read<int>();
 
 		// Number of channels in the layer
-		fread(&channelCount, sizeof(channelCount), 1, file);
-		const auto nbrChannel = (unsigned short)Utils::Calculate(channelCount, sizeof(channelCount));
-		tmpBytesRead += sizeof(channelCount);
-
+		const auto nbrChannel = cursor.Read<unsigned short>();
 		layerData.NbrChannel = nbrChannel;
 
-		// Channel information. Six bytes per channel,
-		unsigned char channelID[2];
+		// Channel information. Six bytes per channel, ten in a PSB.
 		for (int i = 0; i < nbrChannel; i++)
 		{
-			fread(&channelID, sizeof(channelID), 1, file);
-			short channelId = (short) Utils::Calculate(channelID, sizeof(channelID));
-			layerData.ChannelId.push_back(channelId);
-			fread(&dataLength, sizeof(dataLength), 1, file);
-			int length = Utils::Calculate(dataLength, sizeof(dataLength));
-			layerData.ChannelLength.push_back(length);
-			tmpBytesRead += sizeof(channelID);
-			tmpBytesRead += sizeof(dataLength);
+			layerData.ChannelId.push_back(cursor.Read<short>());
+			layerData.ChannelLength.push_back(headerData.ReadLength(cursor));
 		}
 
 		// Blend mode signature: '8BIM'
-		char signature[4];
-		fread(&signature, sizeof(signature), 1, file);
-		tmpBytesRead += sizeof(signature);
-		if (!CheckSignatureLayerInfo(signature))
+		if (!CheckSignatureLayerInfo(cursor.ReadKey()))
 		{
 			return false;
 		}
 
 		// Blend mode key
-		fread(&dataLength, sizeof(dataLength), 1, file);
-		tmpBytesRead += sizeof(dataLength);
+		cursor.Skip(4);
 
 		// Opacity + Clipping + Flag + Filler (zero) each 1 byte
-		unsigned char blendValues[4];
-		fread(&blendValues, sizeof(blendValues), 1, file);
-		tmpBytesRead += sizeof(blendValues);
-
-		bytesRead += tmpBytesRead;
+		cursor.Skip(4);
 		return true;
 	}
 
 	//----------------------------------------------------------------------------------------
-	bool LayerAndMaskReader::ReadLayerInfoSectionExtraDataField(FILE* file, int& bytesRead, LayerData& layerData)
+	bool LayerAndMaskReader::ReadLayerInfoSectionExtraDataField(BigEndianCursor& cursor, const HeaderData& headerData, LayerData& layerData)
 	{
-		unsigned char dataLength[4];
-		unsigned char data[1];
-		int tmpBytesRead = 0;
-
 		//	Length of the extra data field(= the total length of the next five fields).
-		fread(&dataLength, sizeof(dataLength), 1, file);
-		int extraFieldLength = Utils::Calculate(dataLength, sizeof(dataLength));
-		tmpBytesRead += sizeof(dataLength);
+		const unsigned int extraFieldLength = cursor.Read<unsigned int>();
+		BigEndianCursor extraField = cursor.Sub(extraFieldLength);
 
 		// Layer mask / adjustment layer data
-		fread(&dataLength, sizeof(dataLength), 1, file);
-		int layerMaskDataLength = Utils::Calculate(dataLength, sizeof(dataLength));
-		tmpBytesRead += sizeof(dataLength);
-
-		for (int i = 0; i < layerMaskDataLength; i++)
-		{
-			fread(&data, sizeof(data), 1, file);
-			tmpBytesRead += sizeof(data);
-		}
+		extraField.Skip(extraField.Read<unsigned int>());
 
 		// Layer blending ranges data
-		fread(&dataLength, sizeof(dataLength), 1, file);
-		int layerBlendingRangesDataLength = Utils::Calculate(dataLength, sizeof(dataLength));
-		tmpBytesRead += sizeof(dataLength);
-
-		for (int i = 0; i < layerBlendingRangesDataLength; i++)
-		{
-			fread(&data, sizeof(data), 1, file);
-			tmpBytesRead += sizeof(data);
-		}
+		extraField.Skip(extraField.Read<unsigned int>());
 
-		// size string
-		unsigned char sizeString[1];
-		fread(&sizeString, sizeof(sizeString), 1, file);
-		int size = Utils::Calculate(sizeString, sizeof(sizeString));
-		tmpBytesRead += sizeof(sizeString);
-
-		// string name layer
-		unsigned char* nameChars = new unsigned char[size];
-		fread(nameChars, size * sizeof(unsigned char), 1, file);
-		std::string name = Utils::PascalString(size, nameChars);
-		tmpBytesRead += (size * sizeof(unsigned char));
+		// Name of the layer, pascal string padded to a multiple of 4 bytes
+		std::string name = extraField.ReadPascalString(4);
 		std::replace(name.begin(), name.end(), ' ', '_');
 		layerData.LayerName = name;
 
-		// junk from pascal string padded to a multiple of 4 bytes
-		const int junkValueSize = 3 - (size % 4);
-		if (junkValueSize != 4)
+		return ReadHeaderAdditionalLayerInfo(extraField, headerData, layerData);
+	}
+
+	//----------------------------------------------------------------------------------------
+	// A channel to decode, its pixels are filled by the second phase. Huge RLE channels are split
+	// in bands of rows, each band being a job of its own.
+	struct ChannelJob
+	{
+		int Layer;
+		int Channel;
+		BigEndianCursor Data; // The whole channel, or the rows of the band.
+		unsigned char* Pixels; // Slice of the arena.
+		bool Decoded;
+		bool Corrupted;
+		size_t Owner; // Job of the first band, holding the result of the channel. Itself when not split.
+		int FirstRow; // Of a band.
+		std::vector<unsigned int> RowSizes; // Of a band, empty when the job is a whole channel.
+	};
+
+	// RLE channels decoding to more bytes than this are split, in bands of about RLE_BAND_BYTES.
+	static const size_t RLE_SPLIT_BYTES = 16u << 20;
+	static const size_t RLE_BAND_BYTES = 4u << 20;
+
+	//----------------------------------------------------------------------------------------
+	// Band jobs of a RLE channel, from the row sizes in front of its rows. False to keep the channel
+	// whole, when it is small or when the sizes don't match the data: the serial path handles that.
+	static bool SplitRleChannel(BigEndianCursor channel, int rows, size_t rowBytes, const HeaderData& headerData, ChannelJob const& whole, std::vector<ChannelJob>& jobs)
+	{
+		if (rows <= 1 || size_t(rows) * rowBytes < RLE_SPLIT_BYTES) return false;
+		if (channel.Read<short>() != 1) return false;
+
+		std::vector<unsigned int> sizes(rows);
+		unsigned long long total = 0;
+		for (int k = 0; k < rows; k++)
 		{
-			for (int i = 0; i < junkValueSize; i++)
-			{
-				fread(nameChars, sizeof(data), 1, file);
-				tmpBytesRead += sizeof(data);
-			}
+			sizes[k] = headerData.ReadRleRowSize(channel);
+			total += sizes[k];
 		}
+		if (total > channel.Remaining()) return false;
 
-		ReadHeaderAdditionalLayerInfo(file, tmpBytesRead, layerData);
-
-		// Read the extra size 
-		const int sizeToRead = extraFieldLength - tmpBytesRead + 4; // I don't like the +4 but for test.
-		for (int i = 0; i < sizeToRead; i++)
+		const int bandRows = int(std::max<size_t>(1, RLE_BAND_BYTES / std::max<size_t>(1, rowBytes)));
+		const size_t owner = jobs.size();
+		for (int first = 0; first < rows; first += bandRows)
 		{
-			fread(&data, sizeof(data), 1, file);
-			tmpBytesRead += sizeof(data);
+			const int count = std::min(bandRows, rows - first);
+			ChannelJob band = whole;
+			band.Owner = owner;
+			band.FirstRow = first;
+			band.RowSizes.assign(sizes.begin() + first, sizes.begin() + first + count);
+			unsigned long long bytes = 0;
+			for (unsigned int size : band.RowSizes) bytes += size;
+			band.Data = channel.Sub(size_t(bytes));
+			jobs.push_back(std::move(band));
 		}
-		bytesRead += tmpBytesRead;
 		return true;
 	}
 
 	//----------------------------------------------------------------------------------------
-	bool LayerAndMaskReader::ReadChannelImageData(FILE* file, int& bytesRead, int channelDepth, LayerAndMaskData& layerMaskData, PsdProgress const& progress)
+	bool LayerAndMaskReader::ReadChannelImageData(BigEndianCursor& cursor, LayerAndMaskData& layerMaskData)
 	{
-		unsigned char compression[2];
-
-		progress.InitializeProgress(layerMaskData.LayerCount);
+		// Phase one: the channel lengths give the offset of every channel before any decoding.
 		for (int i = 0; i < layerMaskData.LayerCount; i++)
 		{
-			int const nbrChannels = layerMaskData.Layers[i].NbrChannel;
-			int const length = (layerMaskData.Layers[i].AnchorBottom - layerMaskData.Layers[i].AnchorTop)
-				* (layerMaskData.Layers[i].AnchorRight - layerMaskData.Layers[i].AnchorLeft);
-			
-			const int byteperchannel = channelDepth / 8;
-			progress.InitializeSubProgress(length * nbrChannels * byteperchannel);
-
-			for (int j = 0; j < nbrChannels; j++)
+			LayerData& layer = layerMaskData.Layers[i];
+			layer.ChannelOffset.clear();
+			layer.ChannelCompression.clear();
+			for (int j = 0; j < layer.NbrChannel; j++)
 			{
-				// No pixel for user mask
-				if(layerMaskData.Layers[i].ChannelId[j] < -1)
+				// The channel length includes the compression value.
+				layer.ChannelOffset.push_back(cursor.Offset());
+				BigEndianCursor channel = cursor.Sub(size_t(layer.ChannelLength[j]));
+				layer.ChannelCompression.push_back(channel.Size() >= 2 ? channel.Read<short>() : short(-1));
+			}
+		}
+		return true;
+	}
+
+	//----------------------------------------------------------------------------------------
+	void LayerAndMaskReader::HashChannels(BigEndianCursor const& file, LayerAndMaskData& layerMaskData, ReaderParameters const& parameters)
+	{
+		// The record hash seeds the hash of the channels, one layer per task.
+		Parallel::For(layerMaskData.Layers.size(), parameters.ThreadCount, [&](size_t index)
+		{
+			LayerData& layer = layerMaskData.Layers[index];
+			if (parameters.Cancellation.IsCancelled()) return;
+			util::ContentHash hash(layer.RecordHash);
+			try
+			{
+				for (int j = 0; j < layer.NbrChannel && j < int(layer.ChannelOffset.size()); j++)
 				{
-					unsigned char data[1];
-					int size = layerMaskData.Layers[i].ChannelLength[j];
-					for (auto k = 0; k < size; k++)
-					{
-						fread(&data, sizeof(data), 1, file);
-						bytesRead += sizeof(data);
-					}
-					continue;
+					BigEndianCursor channel = file;
+					channel.SeekOffset(layer.ChannelOffset[j]);
+					hash.Update(channel.Take(size_t(layer.ChannelLength[j])), size_t(layer.ChannelLength[j]));
 				}
+				layer.ContentHash = hash.Digest();
+			}
+			catch (std::out_of_range const&)
+			{
+				// Truncated channels, the layer never compares as unchanged.
+				layer.ContentHash = 0;
+			}
+		});
+	}
 
-				// Compression value
-				fread(&compression, sizeof(compression), 1, file);
-				const short compressionValue = short(Utils::Calculate(compression, sizeof(compression)));
-				bytesRead += sizeof(compression);
-
-				// -------------- RAW ------------------
-				switch (compressionValue)
-				{
-				case 0:
+	//----------------------------------------------------------------------------------------
+	bool LayerAndMaskReader::DecodeChannels(BigEndianCursor const& file, const HeaderData& headerData, LayerAndMaskData& layerMaskData, PsdProgress const& progress, ReaderParameters const& parameters)
+	{
+		std::vector<ChannelJob> jobs;
+		size_t arenaSize = PixelArena::ALIGNMENT; // Never empty, empty channels get a pointer too.
+		const bool splitChannels = Parallel::ThreadCount(parameters.ThreadCount) > 1;
+		for (int i = 0; i < int(layerMaskData.Layers.size()); i++)
+		{
+			LayerData& layer = layerMaskData.Layers[i];
+			layer.ImageContent.clear();
+			layer.ImageContentId.clear();
+			for (int j = 0; j < layer.NbrChannel && j < int(layer.ChannelOffset.size()); j++)
+			{
+				// Unwanted channels are never read, the offsets already point past them.
+				if (!IsChannelSelected(layer, layer.ChannelId[j], parameters)) continue;
+
+				BigEndianCursor channel = file;
+				channel.SeekOffset(layer.ChannelOffset[j]);
+				const int rows = layer.AnchorBottom - layer.AnchorTop;
+				const int cols = layer.AnchorRight - layer.AnchorLeft;
+				const ChannelJob whole = { i, j, channel.Sub(size_t(layer.ChannelLength[j])), nullptr, false, false, jobs.size(), 0, {} };
+				if (!splitChannels || cols <= 0 || !SplitRleChannel(whole.Data, rows, size_t(cols) * (headerData.BitsPerPixel / BYTE_VALUE), headerData, whole, jobs))
 				{
-					auto* uncompressedData = static_cast<unsigned char *>(malloc(length));
-					for (int k = 0; k < length; k++)
-					{
-						unsigned char value;
-						fread(&value, sizeof(value), 1, file);
-						uncompressedData[k] = value;
-						progress.IncrementProgress();
-						bytesRead += sizeof(value);
-					}
-					layerMaskData.Layers[i].ImageContent.push_back(uncompressedData);
-					break;
+					jobs.push_back(whole);
 				}
-				// ----------------- RLE ------------------
-				case 1:
+				arenaSize += PixelArena::AlignedSize(ChannelSize(rows, cols, headerData.BitsPerPixel));
+			}
+		}
+
+		// One block for the whole document, reused when the arena already held a document this big.
+		if (layerMaskData.Pixels == nullptr) layerMaskData.Pixels = std::make_shared<PixelArena>();
+		if (!layerMaskData.Pixels->Reset(arenaSize))
+		{
+			std::cout << "[PARSING LAYER AND MASK] Not enough memory for the layer pixels" << std::endl;
+			return false;
+		}
+		for (size_t index = 0; index < jobs.size(); index++)
+		{
+			ChannelJob& job = jobs[index];
+			LayerData const& layer = layerMaskData.Layers[job.Layer];
+			if (job.Owner == index)
+			{
+				job.Pixels = layerMaskData.Pixels->Take(ChannelSize(layer.AnchorBottom - layer.AnchorTop, layer.AnchorRight - layer.AnchorLeft, headerData.BitsPerPixel));
+			}
+			else
+			{
+				job.Pixels = jobs[job.Owner].Pixels + size_t(job.FirstRow) * (layer.AnchorRight - layer.AnchorLeft) * (headerData.BitsPerPixel / BYTE_VALUE);
+			}
+		}
+
+		// Phase two: channels are independent, decode them on the workers.
+		unsigned long long totalBytes = 0;
+		for (ChannelJob const& job : jobs)
+		{
+			totalBytes += job.Data.Size();
+		}
+		ByteProgress decoded(progress, totalBytes);
+
+		Parallel::For(jobs.size(), parameters.ThreadCount, [&](size_t index)
+		{
+			ChannelJob& job = jobs[index];
+			LayerData const& layer = layerMaskData.Layers[job.Layer];
+			try
+			{
+				if (job.RowSizes.empty())
 				{
-					
-					const int rowCount = (layerMaskData.Layers[i].AnchorBottom - layerMaskData.Layers[i].AnchorTop);
-					short* sizes = new short[rowCount];
-
-					unsigned char linePixelCount[2];
-					int lengthGlobal = 0;
-					int indexPosition = 0;
-					auto* uncompressedData = static_cast<unsigned char *>(malloc(length));
-
-					// Read row size information
-					for (int k = 0; k < rowCount; k++)
-					{
-						fread(linePixelCount, sizeof(linePixelCount), 1, file);
-						sizes[k] = short(Utils::Calculate(linePixelCount, sizeof(linePixelCount)));
-						lengthGlobal += sizes[k];
-						bytesRead += sizeof(linePixelCount);
-					}
-
-					// Read data
-					for (int k = 0; k < rowCount; k++)
-					{
-						for (int l = 0; l < sizes[k]; )
-						{
-							unsigned char data[1];
-							// PackBits
-							fread(&data, sizeof(data), 1, file);
-							bytesRead += sizeof(data);
-							short size = short(Utils::Calculate(data, sizeof(data)));
-							l++;
-							if (size > 128)
-							{
-								size = 256 - size;
-								fread(data, sizeof(data), 1, file);
-								l++;
-								bytesRead += sizeof(data);
-								for (short h = 0; h <= size; h++)
-								{
-									uncompressedData[indexPosition] = *data;
-									indexPosition++;
-									progress.IncrementProgress();
-								}
-
-							}
-							else if (size < 128)
-							{
-								for (short h = 0; h <= size; h++)
-								{
-									fread(data, sizeof(data), 1, file);
-									bytesRead += sizeof(data);
-									uncompressedData[indexPosition] = *data;
-									indexPosition++;
-									progress.IncrementProgress();
-									l++;
-								}
-							}
-						}
-					}
-					layerMaskData.Layers[i].ImageContent.push_back(uncompressedData);
-					break;
+					job.Decoded = DecodeChannel(job.Data, layer.AnchorBottom - layer.AnchorTop, layer.AnchorRight - layer.AnchorLeft, headerData, job.Pixels, job.Corrupted, &parameters.Cancellation);
 				}
-				// -------  ZIP without prediction --------
-				// ---------  ZIP with prediction ---------
-				case 2:
-				case 3:
+				else
 				{
-					int rows = (layerMaskData.Layers[i].AnchorBottom - layerMaskData.Layers[i].AnchorTop);
-					int cols = (layerMaskData.Layers[i].AnchorRight - layerMaskData.Layers[i].AnchorLeft);
-					int rowBytes = (cols * channelDepth + 7) / BYTE_VALUE;
-					
-					int lengthChannel = layerMaskData.Layers[i].ChannelLength[j];
-					auto*zipdata = static_cast<unsigned char *>(malloc(lengthChannel));
-					const int count = int(fread(zipdata, 1, lengthChannel - 2, file)); // -2 is a value find in a another code of psd reader.
-
-					auto* unzipdata = static_cast<unsigned char *>(malloc(rows * rowBytes));
-					bool unzipSuccess;
-					if (compressionValue == 2)
-					{
-						unzipSuccess = psd_unzip_without_prediction(zipdata, count, unzipdata, rows * rowBytes);
-					}
-					else
-					{
-						unzipSuccess = psd_unzip_with_prediction(zipdata, count, unzipdata, rows * rowBytes, cols, channelDepth);
-					}
-
-					progress.IncrementProgress();
-					if(unzipSuccess)
-					{
-						layerMaskData.Layers[i].ImageContent.push_back(unzipdata);
-					}
-					
-					break;
-				}
-				default: ;
+					const size_t rowBytes = size_t(layer.AnchorRight - layer.AnchorLeft) * (headerData.BitsPerPixel / BYTE_VALUE);
+					job.Corrupted = !ChannelDecoder::DecodeRle(job.Data.Data(), job.Data.Size(), job.RowSizes, job.Pixels, rowBytes, &parameters.Cancellation);
+					job.Decoded = true;
 				}
 			}
+			catch (std::out_of_range const&)
+			{
+				job.Corrupted = true;
+			}
+			decoded.Add(job.Data.Size());
+		}, [&]()
+		{
+			// Progress callbacks stay on the calling thread.
+			decoded.Publish();
+		});
+		decoded.Publish(true);
 
-			progress.CompleteSubProgress();
-			progress.IncrementProgress();
+		// The bands report to the first band of their channel.
+		for (size_t index = 0; index < jobs.size(); index++)
+		{
+			ChannelJob const& job = jobs[index];
+			if (job.Owner == index) continue;
+			jobs[job.Owner].Decoded &= job.Decoded;
+			jobs[job.Owner].Corrupted |= job.Corrupted;
+		}
+
+		// Store the pixels in channel order, as the serial reading did.
+		for (size_t index = 0; index < jobs.size(); index++)
+		{
+			ChannelJob const& job = jobs[index];
+			if (job.Owner != index) continue;
+			LayerData& layer = layerMaskData.Layers[job.Layer];
+			if (job.Corrupted)
+			{
+				std::cout << "[PARSING LAYER AND MASK] Corrupted data in layer " << layer.LayerName << std::endl;
+			}
+			if (job.Decoded)
+			{
+				layer.ImageContent.push_back(job.Pixels);
+				layer.ImageContentId.push_back(layer.ChannelId[job.Channel]);
+			}
 		}
 		return true;
 	}
 
 	//----------------------------------------------------------------------------------------
-	bool LayerAndMaskReader::ReadGlobalLayerMaskInfo(FILE* file, int& bytesRead, LayerAndMaskData& layerMaskData)
+	size_t LayerAndMaskReader::ChannelSize(int rows, int cols, int channelDepth)
 	{
-		unsigned char dataLength[4];
-
-		fread(&dataLength, sizeof(dataLength), 1, file);
-		const int lengthGlobal = Utils::Calculate(dataLength, sizeof(dataLength));
-		bytesRead += sizeof(dataLength);
+		if (rows <= 0 || cols <= 0) return 0;
+		return size_t(rows) * ((size_t(cols) * channelDepth + 7) / BYTE_VALUE);
+	}
 
-		if (lengthGlobal == 0) return 0;
+	//----------------------------------------------------------------------------------------
+	bool LayerAndMaskReader::IsChannelSelected(LayerData const& layer, short channelId, ReaderParameters const& parameters)
+	{
+		// No pixel for user mask
+		if (channelId < -1) return false;
 
-		int tmpBytesRead = 0;
-		unsigned char data[1];
-		while (tmpBytesRead < lengthGlobal)
+		CHANNEL_SELECTION selection;
+		switch (layer.Type)
 		{
-			fread(&data, sizeof(data), 1, file);
-			tmpBytesRead += sizeof(data);
+		case OPEN_FOLDER:
+		case CLOSED_FOLDER:
+		case HIDDEN_DIVIDER:
+			selection = parameters.FolderChannels;
+			break;
+		case INFLUENCE_LAYER:
+			selection = parameters.InfluenceChannels;
+			break;
+		default:
+			selection = parameters.TextureChannels;
+			break;
 		}
 
-		bytesRead += tmpBytesRead;
-		return true;
+		switch (selection)
+		{
+		case ALL_CHANNELS: return true;
+		case ALPHA_CHANNEL: return channelId == -1;
+		case COLOR_CHANNELS: return channelId >= 0;
+		case FIRST_COLOR_CHANNEL: return channelId == 0;
+		default: return false;
+		}
 	}
 
 	//----------------------------------------------------------------------------------------
-	bool LayerAndMaskReader::ReadHeaderAdditionalLayerInfo(FILE* file, int& bytesRead, LayerData& layerData)
+	bool LayerAndMaskReader::DecodeChannel(BigEndianCursor channel, int rows, int cols, const HeaderData& headerData, unsigned char* destination, bool& corrupted, CancellationToken const* cancellation)
 	{
-		int tmpBytesRead = 0;
-		char signature[4];
+		if (cancellation != nullptr) cancellation->ThrowIfCancelled();
+
+		const int channelDepth = headerData.BitsPerPixel;
+		const int byteperchannel = channelDepth / 8;
 
-		// SIGANTURE
-		fread(&signature, sizeof(signature), 1, file);
-		tmpBytesRead += sizeof(signature);
+		// Compression value
+		const short compressionValue = channel.Read<short>();
 
-		while (CheckSignatureLayerInfo(signature))
+		switch (compressionValue)
 		{
-			AdditionnalLayerDataLayer(file, bytesRead, layerData);
+		// -------------- RAW ------------------
+		case 0:
+		{
+			// Copied by bands of rows to stay cancellable on huge layers.
+			if (rows <= 0 || cols <= 0) return true;
+			const size_t rowBytes = size_t(cols) * byteperchannel;
+			const size_t bandRows = 1024;
+			for (size_t row = 0; row < size_t(rows); row += bandRows)
+			{
+				if (cancellation != nullptr) cancellation->ThrowIfCancelled();
+				channel.ReadBytes(destination + row * rowBytes, std::min(bandRows, size_t(rows) - row) * rowBytes);
+			}
+			return true;
+		}
+		// ----------------- RLE ------------------
+		case 1:
+		{
+			const size_t rowBytes = size_t(cols) * byteperchannel;
 
-			// Try read SIGANTURE
-			fread(&signature, sizeof(signature), 1, file);
-			tmpBytesRead += sizeof(signature);
+			// Read row size information
+			std::vector<unsigned int> sizes(rows);
+			for (int k = 0; k < rows; k++)
+			{
+				sizes[k] = headerData.ReadRleRowSize(channel);
+			}
+
+			// Read data, rows are decoded straight from the channel bytes.
+			const size_t count = channel.Remaining();
+			corrupted = !ChannelDecoder::DecodeRle(channel.Take(count), count, sizes, destination, rowBytes, cancellation);
+			return true;
 		}
+		// -------  ZIP without prediction --------
+		// ---------  ZIP with prediction ---------
+		case 2:
+		case 3:
+		{
+			const size_t rowBytes = (size_t(cols) * channelDepth + 7) / BYTE_VALUE;
 
-		// Check signature failed so go back of 4 bytes, size of the signature.
-		fseek(file, -4, SEEK_CUR);
-		bytesRead += tmpBytesRead;
-		return true;
-	}
+			const size_t count = channel.Remaining();
+			const unsigned char* zipdata = channel.Take(count);
 
+			// Inflated straight from the file bytes into the channel buffer.
+			if (Inflater::Default().Inflate(zipdata, count, destination, rows * rowBytes))
+			{
+				if (compressionValue == 3)
+				{
+					ChannelDecoder::UndoPrediction(destination, size_t(rows), size_t(cols), channelDepth);
+				}
+				return true;
+			}
+
+			corrupted = true;
+			return false;
+		}
+		default:
+			return false;
+		}
+	}
 
 	//----------------------------------------------------------------------------------------
-	bool LayerAndMaskReader::ReadHeaderAdditionalLayerGlobalInfo(FILE* file, int& bytesRead, const HeaderData& headerData, LayerAndMaskData& layerDataMaskData, PsdProgress const& progress)
+	bool LayerAndMaskReader::ReadGlobalLayerMaskInfo(BigEndianCursor& cursor)
 	{
-		int tmpBytesRead = 0;
-		char signature[4];
+		if (cursor.AtEnd()) return false;
 
-		// SIGANTURE
-		fread(&signature, sizeof(signature), 1, file);
-		tmpBytesRead += sizeof(signature);
+		const unsigned int lengthGlobal = cursor.Read<unsigned int>();
+		cursor.Skip(lengthGlobal);
+		return true;
+	}
 
-		while (CheckSignatureLayerInfo(signature))
+	//----------------------------------------------------------------------------------------
+	bool LayerAndMaskReader::ReadHeaderAdditionalLayerInfo(BigEndianCursor& cursor, const HeaderData& headerData, LayerData& layerData)
+	{
+		// Signature, key and length at least.
+		while (cursor.Remaining() >= 12)
 		{
-			AdditionnalLayerDataGlobal(file, bytesRead, headerData, layerDataMaskData, progress);
-
-			// Try read SIGANTURE
-			fread(&signature, sizeof(signature), 1, file);
-			tmpBytesRead += sizeof(signature);
+			if (!CheckSignatureLayerInfo(cursor.ReadKey())) return false;
+			AdditionnalLayerDataLayer(cursor, headerData, layerData);
 		}
-
-		// Check signature failed so go back of 4 bytes, size of the signature.
-		fseek(file, -4, SEEK_CUR);
-		bytesRead += tmpBytesRead;
 		return true;
 	}
 
+
 	//----------------------------------------------------------------------------------------
-	void LayerAndMaskReader::AdditionnalLayerDataGlobal(FILE* file, int& bytesRead, const HeaderData& headerData, LayerAndMaskData& layerDataMaskData, PsdProgress const& progress)
+	bool LayerAndMaskReader::ReadHeaderAdditionalLayerGlobalInfo(BigEndianCursor& cursor, const HeaderData& headerData, LayerAndMaskData& layerDataMaskData)
 	{
-		char dataKey[4];
-		unsigned char data[1];
-		unsigned char dataLength[4];
-
-		// KEY
-		fread(&dataKey, sizeof(dataKey), 1, file);
-		bytesRead += sizeof(dataKey);
-		const std::string key(dataKey, 4);
-
-		// LAYERS
-		if (key == KEY_LAYERS)
+		// Signature, key and length at least.
+		while (cursor.Remaining() >= 12)
 		{
-			ProcessLayerMaskInformation(file, bytesRead, headerData, layerDataMaskData, progress);
-			return;
+			if (!CheckSignatureLayerInfo(cursor.ReadKey())) return false;
+			AdditionnalLayerDataGlobal(cursor, headerData, layerDataMaskData);
 		}
+		return true;
+	}
+
+	//----------------------------------------------------------------------------------------
+	void LayerAndMaskReader::AdditionnalLayerDataGlobal(BigEndianCursor& cursor, const HeaderData& headerData, LayerAndMaskData& layerDataMaskData)
+	{
+		// KEY
+		const std::string key = cursor.ReadKey();
 
 		// LENGHT
-		fread(&dataLength, sizeof(dataLength), 1, file);
-		unsigned int size = (unsigned int)Utils::Calculate(dataLength, sizeof(dataLength));
-		bytesRead += sizeof(dataLength);
-		size += (size % 2);
-		bytesRead += size * sizeof(data);
+		const unsigned long long size = ReadBlockLength(cursor, headerData, key);
+		BigEndianCursor block = cursor.Sub(size_t(size));
+		if (size % 2 && !cursor.AtEnd()) cursor.Skip(1);
 
-		fseek(file, size, SEEK_CUR);
+		// LAYERS, same content as the layers info section, the block length being its length.
+		if (key == KEY_LAYERS || key == KEY_LAYERS_32)
+		{
+			ReadLayerInfoSection(block, headerData, layerDataMaskData);
+		}
 	}
 
 	//----------------------------------------------------------------------------------------
-	void LayerAndMaskReader::AdditionnalLayerDataLayer(FILE* file, int& bytesRead, LayerData& layerData)
+	void LayerAndMaskReader::AdditionnalLayerDataLayer(BigEndianCursor& cursor, const HeaderData& headerData, LayerData& layerData)
 	{
-		char dataKey[4];
-		unsigned char dataLength[4];
-
 		// KEY
-		fread(&dataKey, sizeof(dataKey), 1, file);
-		bytesRead += sizeof(dataKey);
-		std::string key(dataKey, 4);
+		const std::string key = cursor.ReadKey();
 
 		// LENGHT
-		fread(&dataLength, sizeof(dataLength), 1, file);
-		unsigned int size = (unsigned int)Utils::Calculate(dataLength, sizeof(dataLength));
-		bytesRead += sizeof(dataLength);
-		size += (size % 2);
-		bytesRead += size;
+		const unsigned long long size = ReadBlockLength(cursor, headerData, key);
+		BigEndianCursor block = cursor.Sub(size_t(size));
+		if (size % 2 && !cursor.AtEnd()) cursor.Skip(1);
 
 		// Key group
 		if (key == KEY_GROUP)
 		{
-			SectionDividerSetting(file, size, layerData);
+			SectionDividerSetting(block, layerData);
 			return;
 		}
 
 		// Key group
 		if (key == KEY_VECTOR_MASK || key == KEY_MASK)
 		{
-			ReadVectorMask(file, size, layerData);
-			return;
+			ReadVectorMask(block, layerData);
 		}
-
-		fseek(file, size, SEEK_CUR);
 	}
 
 #pragma region ADDITIONNAL LAYER DATA
 
 	//----------------------------------------------------------------------------------------
-	void LayerAndMaskReader::SectionDividerSetting(FILE* file, int const& size, LayerData& layerData)
+	void LayerAndMaskReader::SectionDividerSetting(BigEndianCursor& cursor, LayerData& layerData)
 	{
-		unsigned char typeData[4];
-
 		// type layer
-		fread(&typeData, sizeof(typeData), 1, file);
-		const unsigned int type = Utils::Calculate(typeData, sizeof(typeData));
+		const unsigned int type = cursor.Read<unsigned int>();
 		layerData.Type = static_cast<TYPE_LAYER>(type);
-
-		if (size <= 4) return;
-
-		fseek(file, size, SEEK_CUR);
 	}
 
 
 	//----------------------------------------------------------------------------------------
-	void LayerAndMaskReader::ReadVectorMask(FILE* file, int const& size, LayerData& layerData)
+	void LayerAndMaskReader::ReadVectorMask(BigEndianCursor& cursor, LayerData& layerData)
 	{
-		unsigned char typeData[4];
-
-		// Type version
-		fread(&typeData, sizeof(typeData), 1, file);
-		// Flag
-		fread(&typeData, sizeof(typeData), 1, file);
-		
-		const int sizeRecordPath = (size - 8);
-		ReadPaths(file, layerData.PathRecords, sizeRecordPath);
-
-		const int sizeJunk = sizeRecordPath % PATH_BLOCK_SIZE;
-		
-		fseek(file, sizeJunk, SEEK_CUR);
+		// Type version + Flag
+		cursor.Skip(8);
+		ReadPaths(cursor, layerData.PathRecords);
 	}
 
 	//----------------------------------------------------------------------------------------
-	bool LayerAndMaskReader::ReadPaths(FILE* file, std::vector<util::PathRecord> & pathRecords, int sizeBlock)
+	bool LayerAndMaskReader::ReadPaths(BigEndianCursor& cursor, util::PathStore& pathRecords)
 	{
-		if (sizeBlock <= 0) return false;
-		unsigned char selectorData[2];
-		const int size = sizeBlock / 26;
+		const size_t size = cursor.Remaining() / PATH_BLOCK_SIZE;
+		if (size == 0) return false;
 
-		PathRecord pathRecord;
-		for (auto i = 0; i < size; i++)
+		for (size_t i = 0; i < size; i++)
 		{
-			fread(selectorData, sizeof(selectorData), 1, file);
-			const auto selector = short(Utils::Calculate(selectorData, sizeof(selectorData)));
+			const auto selector = cursor.Read<short>();
 			switch (selector)
 			{
 			case 0:
 			case 3:
 			{
-				if (!pathRecord.Points.empty() && !(pathRecord.IsClosedPath && pathRecord.Points.size() <= 2))
-				{
-					pathRecords.push_back(pathRecord);
-				}
-
-				pathRecord =  PathRecord();
-				pathRecord.IsClosedPath = (selector == 0);
-
-				unsigned char pathRecordData[24];
-				fread(pathRecordData, sizeof(pathRecordData), 1, file);
+				pathRecords.BeginPath(selector == 0);
+				cursor.Skip(24);
 				break;
 			}
 			case 1:
@@ -650,107 +634,39 @@ namespace psd_reader
 			case 2:
 			case 5:
 			{
-				PathPoints* points = ReadPathPoint(file);
-				points->IsLinked = (selector == 1 || selector == 4);
-				pathRecord.Points.push_back(points);
+				PathPoints points = ReadPathPoint(cursor);
+				points.IsLinked = (selector == 1 || selector == 4);
+				pathRecords.AddPoint(points);
 				break;
 			}
 			default:
 			{
-				unsigned char pathRecordData[24];
-				fread(pathRecordData, sizeof(pathRecordData), 1, file);
+				cursor.Skip(24);
 				break;
 			}
 			}
 		}
 
-		if (!pathRecord.Points.empty() && !(pathRecord.IsClosedPath && pathRecord.Points.size() <= 2))
-		{
-			pathRecords.push_back(pathRecord);
-		}
+		pathRecords.EndPath();
 		return true;
 	}
 
 	//----------------------------------------------------------------------------------------
-	PathPoints* LayerAndMaskReader::ReadPathPoint(FILE * file)
+	PathPoints LayerAndMaskReader::ReadPathPoint(BigEndianCursor& cursor)
 	{
+		PathPoints pathPoints;
 
-		unsigned char pathRecordData[24];
-		PathPoints* pathPoints = new PathPoints();
-
-		fread(pathRecordData, sizeof(pathRecordData), 1, file);
-
-		pathPoints->SegIn.y = ImageResourceReader::fixedPoint(&pathRecordData[0], true, 32, 8);
-		pathPoints->SegIn.x = ImageResourceReader::fixedPoint(&pathRecordData[4], true, 32, 8);
+		pathPoints.SegIn.y = cursor.ReadFixed8_24();
+		pathPoints.SegIn.x = cursor.ReadFixed8_24();
 
-		pathPoints->AnchorPoint.y = ImageResourceReader::fixedPoint(&pathRecordData[8], true, 32, 8);
-		pathPoints->AnchorPoint.x = ImageResourceReader::fixedPoint(&pathRecordData[12], true, 32, 8);
+		pathPoints.AnchorPoint.y = cursor.ReadFixed8_24();
+		pathPoints.AnchorPoint.x = cursor.ReadFixed8_24();
 
-		pathPoints->SegOut.y = ImageResourceReader::fixedPoint(&pathRecordData[16], true, 32, 8);
-		pathPoints->SegOut.x = ImageResourceReader::fixedPoint(&pathRecordData[20], true, 32, 8);
+		pathPoints.SegOut.y = cursor.ReadFixed8_24();
+		pathPoints.SegOut.x = cursor.ReadFixed8_24();
 
 		return pathPoints;
 	}
 
-	//----------------------------------------------------------------------------------------
-	bool LayerAndMaskReader::psd_unzip_without_prediction(unsigned char *src_buf, int src_len, unsigned char *dst_buf, int dst_len)
-	{
-		z_stream stream;
-		int state;
-
-		memset(&stream, 0, sizeof(z_stream));
-		stream.data_type = Z_BINARY;
-
-		stream.next_in = (Bytef *)src_buf;
-		stream.avail_in = src_len;
-		stream.next_out = (Bytef *)dst_buf;
-		stream.avail_out = dst_len;
-
-		if (inflateInit(&stream) != Z_OK) return true;
-
-		do {
-			state = inflate(&stream, Z_PARTIAL_FLUSH);
-			if (state == Z_STREAM_END) break;
-			if (state == Z_DATA_ERROR || state != Z_OK) break;
-
-		} while (stream.avail_out > 0);
-
-		return state == Z_STREAM_END || state == Z_OK;
-	}
-
-	//----------------------------------------------------------------------------------------
-	bool LayerAndMaskReader::psd_unzip_with_prediction(unsigned char *src_buf, int src_len,	unsigned char *dst_buf, int dst_len, int row_size, int color_depth)
-	{
-		const bool res = psd_unzip_without_prediction(src_buf, src_len, dst_buf, dst_len);
-		if (!res) return res;
-
-		unsigned char *buf = dst_buf;
-		do {
-			int len = row_size;
-			if (color_depth == 16)
-			{
-				while (--len)
-				{
-					buf[2] += buf[0] + ((buf[1] + buf[3]) >> 8);
-					buf[3] += buf[1];
-					buf += 2;
-				}
-				buf += 2;
-				dst_len -= row_size * 2;
-			}
-			else
-			{
-				while (--len)
-				{
-					*(buf + 1) += *buf;
-					buf++;
-				}
-				buf++;
-				dst_len -= row_size;
-			}
-		} while (dst_len > 0);
-		return res;
-	}
-
 #pragma endregion
 }
\ No newline at end of file
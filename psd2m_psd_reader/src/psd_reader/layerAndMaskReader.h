@@ -21,13 +21,19 @@
 #include <iostream>
 #include "util/vectorialPath.h"
 #include "headerReader.h"
+#include "util/bigEndianCursor.h"
 #include "progress.h"
+#include "cancellation.h"
+#include "pixelArena.h"
+#include <memory>
+#include <unordered_map>
 
 namespace psd_reader
 {
 #pragma region DATA
 	
 	static const std::string KEY_LAYERS = "Lr16";
+	static const std::string KEY_LAYERS_32 = "Lr32";
 	static const std::string KEY_GROUP = "lsct";
 	static const std::string KEY_VECTOR_MASK = "vmsk";
 	static const std::string KEY_MASK = "vsms";
@@ -44,13 +50,44 @@ namespace psd_reader
 		INFLUENCE_LAYER = 4
 	};
 
+	// Channels decoded for a kind of layer. User masks (id below -1) are never decoded.
+	enum CHANNEL_SELECTION
+	{
+		ALL_CHANNELS = 0,
+		ALPHA_CHANNEL = 1, // Transparency only, id -1.
+		COLOR_CHANNELS = 2, // Ids 0 and above.
+		FIRST_COLOR_CHANNEL = 3, // Red or gray, id 0.
+		NO_CHANNEL = 4
+	};
+
+	//----------------------------------------------------------------------------------------------
+	struct ReaderParameters
+	{
+		unsigned ThreadCount = 0; // Threads decoding the channels, 0 for one per hardware thread, 1 to decode serially.
+		bool StructureOnly = false; // Skip the pixels, layers are decoded on demand with PsdReader::DecodeLayer.
+		unsigned long long CacheBudget = 512ull << 20; // Bytes of decoded channels kept by PsdReader, 0 for no limit.
+		bool UseSidecarIndex = true; // Reuse the structure saved in the output folder when the file didn't change.
+		bool DecodeComposite = false; // Decode the merged image into ImageData::Rgba.
+		bool SinglePlate = false; // Merged image only, no layer is decoded. Implies DecodeComposite.
+		CHANNEL_SELECTION TextureChannels = ALL_CHANNELS; // Texture layers and other layers with pixels.
+		CHANNEL_SELECTION InfluenceChannels = FIRST_COLOR_CHANNEL; // Influence layers, read as a gray mask.
+		CHANNEL_SELECTION FolderChannels = NO_CHANNEL; // Folders and section dividers.
+		bool HashLayers = false; // LayerData::ContentHash for PsdDiff, reads the compressed bytes of every channel once. See PsdReader::HashLayers.
+		CancellationToken Cancellation; // Checked between the sections and the rows, ParsePsd returns empty data once cancelled.
+	};
+
+	//----------------------------------------------------------------------------------------------
 	struct LayerData
 	{
 		std::string LayerName;
 		TYPE_LAYER Type = TEXTURE_LAYER;
 		std::vector<short> ChannelId;
-		std::vector<int> ChannelLength;
-		std::vector<util::PathRecord> PathRecords;
+		std::vector<unsigned long long> ChannelLength; // Compression value included.
+		std::vector<unsigned long long> ChannelOffset; // Position in the file of each channel data, compression value included.
+		std::vector<short> ChannelCompression; // 0 raw, 1 RLE, 2 ZIP, 3 ZIP with prediction, -1 if empty.
+		util::PathStore PathRecords;
+		unsigned long long RecordHash = 0; // Rectangle, channels, name and vector mask, seeds ContentHash.
+		unsigned long long ContentHash = 0; // Record, vector mask and compressed channels, 0 when not computed. See PsdDiff.
 		
 		int NbrChannel = 0;
 		int AnchorTop = 0;
@@ -58,14 +95,26 @@ namespace psd_reader
 		int AnchorBottom = 0;
 		int AnchorLeft = 0;
 
-		// Layer texture DATA stored per Channel, ordered ARGB.
+		// Layer texture DATA of the selected channels only, in ImageContentId order: look a channel up
+		// with GetChannelContent rather than by position. Owned by LayerAndMaskData::Pixels.
 		std::vector<unsigned char*> ImageContent;
+		std::vector<short> ImageContentId; // Channel id of each ImageContent, only the selected channels are decoded.
 
 		LayerData()= default;
 		~LayerData()
 		{
 			LayerName = "";
 		};
+
+		// Decoded pixels of a channel, nullptr when the channel wasn't decoded.
+		unsigned char* GetChannelContent(short channelId) const
+		{
+			for (size_t i = 0; i < ImageContentId.size() && i < ImageContent.size(); i++)
+			{
+				if (ImageContentId[i] == channelId) return ImageContent[i];
+			}
+			return nullptr;
+		};
 	};
 
 	//----------------------------------------------------------------------------------------------
@@ -73,6 +122,9 @@ namespace psd_reader
 	{
 		short LayerCount;
 		std::vector<LayerData> Layers;
+		std::shared_ptr<PixelArena> Pixels; // Pixels of every layer, released with the last copy of the data.
+		std::unordered_map<std::string, int> LayerIndex; // Position in Layers by name, see BuildIndex.
+		std::unordered_map<std::string, int> InfluenceIndex; // Influence layer by name of the layer it applies to.
 		static const std::string INFLUENCE_LAYER_TAG;
 
 		LayerAndMaskData()
@@ -86,17 +138,31 @@ namespace psd_reader
 			LayerCount = 0;
 		};
 
-		int GetIndexInfluenceLayer(std::string name) const
+		// Called by the readers once Layers is complete, the first layer of a name wins.
+		void BuildIndex()
 		{
-			for(auto i = 0; i < Layers.size(); i++)
+			LayerIndex.clear();
+			InfluenceIndex.clear();
+			for (int i = 0; i < int(Layers.size()); i++)
 			{
-				if (Layers[i].Type == INFLUENCE_LAYER &&
-					LayerNameInfluenceAssociated( Layers[i].LayerName) == name)
+				LayerIndex.emplace(Layers[i].LayerName, i);
+				if (Layers[i].Type == INFLUENCE_LAYER)
 				{
-					return i;
+					InfluenceIndex.emplace(LayerNameInfluenceAssociated(Layers[i].LayerName), i);
 				}
 			}
-			return -1;
+		};
+
+		int GetIndexLayer(std::string const& name) const
+		{
+			const auto found = LayerIndex.find(name);
+			return found != LayerIndex.end() ? found->second : -1;
+		};
+
+		int GetIndexInfluenceLayer(std::string const& name) const
+		{
+			const auto found = InfluenceIndex.find(name);
+			return found != InfluenceIndex.end() ? found->second : -1;
 		};
 
 		static std::string LayerNameInfluenceAssociated(std::string const& str);
@@ -114,25 +180,33 @@ namespace psd_reader
 
 		LayerAndMaskReader() = default;
 		~LayerAndMaskReader() = default;
-		static bool Read(FILE* file, const HeaderData& headerData, LayerAndMaskData & layerMaskData, PsdProgress const& progress);
-		static void ProcessLayerMaskInformation(FILE* file, int& bytesRead, const HeaderData& headerData, LayerAndMaskData& layerMaskData, PsdProgress const& progress);
+		static bool Read(util::BigEndianCursor& cursor, const HeaderData& headerData, LayerAndMaskData & layerMaskData);
+		// LayerData::ContentHash from the record hash and the compressed channel bytes, nothing is decoded.
+		static void HashChannels(util::BigEndianCursor const& file, LayerAndMaskData& layerMaskData, ReaderParameters const& parameters);
+		// Decode the pixels of every layer from the channel offsets, file being a cursor on the layer and mask section.
+		static bool DecodeChannels(util::BigEndianCursor const& file, const HeaderData& headerData, LayerAndMaskData& layerMaskData, PsdProgress const& progress, ReaderParameters const& parameters);
+		// Decode a channel into destination, of ChannelSize bytes. False if nothing could be decoded.
+		// Throws ParseCancelled when the cancellation, if any, is set between two rows.
+		static bool DecodeChannel(util::BigEndianCursor channel, int rows, int cols, const HeaderData& headerData, unsigned char* destination, bool& corrupted, CancellationToken const* cancellation = nullptr);
+		static size_t ChannelSize(int rows, int cols, int channelDepth);
+		// Whether the channel is decoded for this layer according to the selections of the parameters.
+		static bool IsChannelSelected(LayerData const& layer, short channelId, ReaderParameters const& parameters);
+		static void ProcessLayerMaskInformation(util::BigEndianCursor& cursor, const HeaderData& headerData, LayerAndMaskData& layerMaskData);
 
 	private:
-		static bool ReadLayerInfoSection(FILE* file, int& bytesRead, const HeaderData& headerData, LayerAndMaskData& layerMaskData, PsdProgress const& progress);
-		static bool ReadLayerRecordsSection(FILE * file, int & bytesRead, LayerData& layerData);
-		static bool ReadLayerInfoSectionExtraDataField(FILE* file, int& bytesRead, LayerData& layerData);
-		static bool ReadChannelImageData(FILE* file, int& bytesRead, int channelDepth, LayerAndMaskData& layerMaskData, PsdProgress const& progress);
-		static bool ReadGlobalLayerMaskInfo(FILE* file, int& bytesRead, LayerAndMaskData& layerMaskData);
-		static bool ReadHeaderAdditionalLayerInfo(FILE* file, int& bytesRead, LayerData& layerData);
-		static bool ReadHeaderAdditionalLayerGlobalInfo(FILE* file, int& bytesRead, const HeaderData& headerData, LayerAndMaskData& layerDataMaskData, PsdProgress const& progress);
-		static void AdditionnalLayerDataGlobal(FILE* file, int& bytesRead, const HeaderData& headerData, LayerAndMaskData& layerDataMaskData, PsdProgress const& progress);
-		static void AdditionnalLayerDataLayer(FILE* file, int& bytesRead, LayerData& layerData);
-		static void SectionDividerSetting(FILE * file, int const & size, LayerData& layerData);
-		static void ReadVectorMask(FILE* file, int const& size, LayerData& layerData);
-		static bool ReadPaths(FILE* file, std::vector<util::PathRecord>& pathRecords, int sizeBlock);
-		static util::PathPoints* ReadPathPoint(FILE* file);
-		static bool psd_unzip_without_prediction(unsigned char *src_buf, int src_len, unsigned char *dst_buf, int dst_len);
-		static bool psd_unzip_with_prediction(unsigned char* src_buf, int src_len, unsigned char* dst_buf, int dst_len, int row_size, int color_depth);
+		static bool ReadLayerInfoSection(util::BigEndianCursor& cursor, const HeaderData& headerData, LayerAndMaskData& layerMaskData);
+		static bool ReadLayerRecordsSection(util::BigEndianCursor& cursor, const HeaderData& headerData, LayerData& layerData);
+		static bool ReadLayerInfoSectionExtraDataField(util::BigEndianCursor& cursor, const HeaderData& headerData, LayerData& layerData);
+		static bool ReadChannelImageData(util::BigEndianCursor& cursor, LayerAndMaskData& layerMaskData);
+		static bool ReadGlobalLayerMaskInfo(util::BigEndianCursor& cursor);
+		static bool ReadHeaderAdditionalLayerInfo(util::BigEndianCursor& cursor, const HeaderData& headerData, LayerData& layerData);
+		static bool ReadHeaderAdditionalLayerGlobalInfo(util::BigEndianCursor& cursor, const HeaderData& headerData, LayerAndMaskData& layerDataMaskData);
+		static void AdditionnalLayerDataGlobal(util::BigEndianCursor& cursor, const HeaderData& headerData, LayerAndMaskData& layerDataMaskData);
+		static void AdditionnalLayerDataLayer(util::BigEndianCursor& cursor, const HeaderData& headerData, LayerData& layerData);
+		static void SectionDividerSetting(util::BigEndianCursor& cursor, LayerData& layerData);
+		static void ReadVectorMask(util::BigEndianCursor& cursor, LayerData& layerData);
+		static bool ReadPaths(util::BigEndianCursor& cursor, util::PathStore& pathRecords);
+		static util::PathPoints ReadPathPoint(util::BigEndianCursor& cursor);
 	};
 
 #pragma endregion
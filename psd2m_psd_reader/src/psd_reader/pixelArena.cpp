@@ -0,0 +1,76 @@
+//----------------------------------------------------------------------------------------------
+// ===============================================
+//  Copyright (C) 2026, E.D. Films.
+//  All Rights Reserved.
+// ===============================================
+//  Unauthorized copying of this file, via any medium is strictly prohibited
+//  Proprietary and confidential
+//
+//  @file pixelArena.cpp
+//  @author Michaelson Britt
+//  @date 16-10-2026
+//
+//  @section DESCRIPTION
+//
+//----------------------------------------------------------------------------------------------
+
+#include "pixelArena.h"
+#include <algorithm>
+#include <cstdlib>
+
+namespace psd_reader
+{
+	//----------------------------------------------------------------------------------------
+	const size_t PixelArena::ALIGNMENT(64);
+
+	//----------------------------------------------------------------------------------------
+	PixelArena::PixelArena() : PixelArena(malloc, free)
+	{
+	}
+
+	//----------------------------------------------------------------------------------------
+	PixelArena::PixelArena(AllocateFunction allocate, ReleaseFunction release)
+		: Allocate(std::move(allocate)), Free(std::move(release))
+	{
+	}
+
+	//----------------------------------------------------------------------------------------
+	PixelArena::~PixelArena()
+	{
+		Release();
+	}
+
+	//----------------------------------------------------------------------------------------
+	bool PixelArena::Reset(size_t size)
+	{
+		this->Position = 0;
+		if (size <= this->BlockSize) return true;
+
+		// Released first, the old and the new blocks are never held together.
+		Release();
+		this->Block = static_cast<unsigned char*>(this->Allocate(size));
+		if (this->Block == nullptr) return false;
+
+		this->BlockSize = size;
+		return true;
+	}
+
+	//----------------------------------------------------------------------------------------
+	unsigned char* PixelArena::Take(size_t size)
+	{
+		if (this->Block == nullptr || size > this->BlockSize - this->Position) return nullptr;
+
+		unsigned char* slice = this->Block + this->Position;
+		this->Position += std::min(AlignedSize(size), this->BlockSize - this->Position);
+		return slice;
+	}
+
+	//----------------------------------------------------------------------------------------
+	void PixelArena::Release()
+	{
+		if (this->Block != nullptr) this->Free(this->Block);
+		this->Block = nullptr;
+		this->BlockSize = 0;
+		this->Position = 0;
+	}
+}
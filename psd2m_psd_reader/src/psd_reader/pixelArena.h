@@ -0,0 +1,68 @@
+//----------------------------------------------------------------------------------------------
+// ===============================================
+//  Copyright (C) 2026, E.D. Films.
+//  All Rights Reserved.
+// ===============================================
+//  Unauthorized copying of this file, via any medium is strictly prohibited
+//  Proprietary and confidential
+//
+//  @file pixelArena.h
+//  @author Michaelson Britt
+//  @date 16-10-2026
+//
+//  @section DESCRIPTION
+//  One block holding the pixels of every layer of a document, released with its last owner.
+//
+//----------------------------------------------------------------------------------------------
+
+#ifndef PIXELARENA_H
+#define PIXELARENA_H
+
+#include <cstddef>
+#include <functional>
+
+namespace psd_reader
+{
+#pragma region ARENA
+
+	//----------------------------------------------------------------------------------------------
+	class PixelArena
+	{
+	public:
+		typedef std::function<void*(size_t)> AllocateFunction;
+		typedef std::function<void(void*)> ReleaseFunction;
+
+		// Slices start on multiples of ALIGNMENT from the start of the block.
+		static const size_t ALIGNMENT;
+
+		PixelArena(); // malloc and free
+		PixelArena(AllocateFunction allocate, ReleaseFunction release);
+		~PixelArena();
+		PixelArena(PixelArena const&) = delete;
+		PixelArena& operator=(PixelArena const&) = delete;
+
+		// Empty the arena and make room for size bytes. The block is kept when it is big enough,
+		// so parsing the same document again allocates nothing.
+		bool Reset(size_t size);
+
+		// Next slice of size bytes, nullptr when the arena is full.
+		unsigned char* Take(size_t size);
+
+		void Release();
+		size_t Capacity() const { return this->BlockSize; }
+		size_t Used() const { return this->Position; }
+
+		static size_t AlignedSize(size_t size) { return (size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT; }
+
+	private:
+		AllocateFunction Allocate;
+		ReleaseFunction Free;
+		unsigned char* Block = nullptr;
+		size_t BlockSize = 0;
+		size_t Position = 0;
+	};
+
+#pragma endregion
+}
+
+#endif // PIXELARENA_H
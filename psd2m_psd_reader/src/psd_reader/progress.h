@@ -17,7 +17,12 @@
 #ifndef PROGRESS_H
 #define PROGRESS_H
 
+#include <atomic>
+#include <chrono>
 #include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 namespace psd_reader
 {
@@ -71,5 +76,120 @@ namespace psd_reader
 		std::function<void()> FuncIncrementProgress;
 		std::function<void()> FuncCompleteSubProgress;
 	};
+
+	//----------------------------------------------------------------------------------------------
+	// Progress counted in bytes. Workers add the bytes they decoded to an atomic counter, the
+	// calling thread publishes it through PsdProgress in STEPS increments, not more than once per
+	// PUBLISH_INTERVAL so the callbacks never cost more than the decoding.
+	class ByteProgress
+	{
+	public:
+		static const unsigned STEPS = 100;
+		static const long long PUBLISH_INTERVAL = 50; // Milliseconds.
+
+		ByteProgress(PsdProgress const& progress, unsigned long long totalBytes)
+			: Progress(progress), Total(totalBytes), Done(0), Published(0), LastPublish(std::chrono::steady_clock::now())
+		{
+			this->Progress.InitializeProgress(STEPS);
+		}
+
+		// Any thread.
+		void Add(unsigned long long bytes)
+		{
+			this->Done.fetch_add(bytes, std::memory_order_relaxed);
+		}
+
+		// Calling thread only. Everything added so far is published when finished.
+		void Publish(bool finished = false)
+		{
+			const auto now = std::chrono::steady_clock::now();
+			if (!finished && std::chrono::duration_cast<std::chrono::milliseconds>(now - this->LastPublish).count() < PUBLISH_INTERVAL) return;
+			this->LastPublish = now;
+
+			const unsigned long long done = this->Done.load(std::memory_order_relaxed);
+			const unsigned steps = (this->Total == 0 || done >= this->Total) ? STEPS : unsigned(double(done) / double(this->Total) * STEPS);
+			for (; this->Published < steps; ++this->Published)
+			{
+				this->Progress.IncrementProgress();
+			}
+		}
+
+	private:
+		PsdProgress const& Progress;
+		const unsigned long long Total;
+		std::atomic<unsigned long long> Done;
+		unsigned Published;
+		std::chrono::steady_clock::time_point LastPublish;
+	};
+
+	//----------------------------------------------------------------------------------------------
+	// Progress of a parsing running on another thread. The parsing pushes its calls through
+	// MakeProducer, the host replays them on its own thread with Drain, so the host callbacks
+	// never run on the parsing thread.
+	class ProgressQueue
+	{
+	public:
+		enum EVENT_TYPE
+		{
+			INITIALIZE,
+			INITIALIZE_SUB,
+			INCREMENT,
+			COMPLETE_SUB
+		};
+
+		struct Event
+		{
+			EVENT_TYPE Type;
+			unsigned Count; // Steps of INITIALIZE and INITIALIZE_SUB, repetitions of INCREMENT.
+		};
+
+		// Any thread. Consecutive increments are merged.
+		void Push(EVENT_TYPE type, unsigned count)
+		{
+			std::lock_guard<std::mutex> lock(this->Mutex);
+			if (type == INCREMENT && !this->Events.empty() && this->Events.back().Type == INCREMENT)
+			{
+				this->Events.back().Count += count;
+				return;
+			}
+			this->Events.push_back({ type, count });
+		}
+
+		// Host thread. Replays the pending events on progress, returns how many were pending.
+		size_t Drain(PsdProgress const& progress)
+		{
+			std::vector<Event> events;
+			{
+				std::lock_guard<std::mutex> lock(this->Mutex);
+				events.swap(this->Events);
+			}
+
+			for (auto const& event : events)
+			{
+				switch (event.Type)
+				{
+				case INITIALIZE: progress.InitializeProgress(event.Count); break;
+				case INITIALIZE_SUB: progress.InitializeSubProgress(event.Count); break;
+				case INCREMENT: for (unsigned i = 0; i < event.Count; ++i) progress.IncrementProgress(); break;
+				case COMPLETE_SUB: progress.CompleteSubProgress(); break;
+				}
+			}
+			return events.size();
+		}
+
+		// Progress for the parsing thread, whose calls are queued.
+		static PsdProgress MakeProducer(std::shared_ptr<ProgressQueue> const& queue)
+		{
+			std::function<void(unsigned)> initialize = [queue](unsigned n) { queue->Push(INITIALIZE, n); };
+			std::function<void(unsigned)> initializeSub = [queue](unsigned n) { queue->Push(INITIALIZE_SUB, n); };
+			std::function<void()> increment = [queue]() { queue->Push(INCREMENT, 1); };
+			std::function<void()> completeSub = [queue]() { queue->Push(COMPLETE_SUB, 0); };
+			return PsdProgress(initialize, initializeSub, increment, completeSub);
+		}
+
+	private:
+		std::mutex Mutex;
+		std::vector<Event> Events;
+	};
 }
 #endif // PROGRESS_H
@@ -0,0 +1,108 @@
+//----------------------------------------------------------------------------------------------
+// ===============================================
+//  Copyright (C) 2026, E.D. Films.
+//  All Rights Reserved.
+// ===============================================
+//  Unauthorized copying of this file, via any medium is strictly prohibited
+//  Proprietary and confidential
+//
+//  @file psdDiff.cpp
+//  @author Michaelson Britt
+//  @date 16-10-2026
+//
+//  @section DESCRIPTION
+//
+//----------------------------------------------------------------------------------------------
+
+#include "psdDiff.h"
+#include <algorithm>
+#include <deque>
+#include <unordered_map>
+
+namespace psd_reader
+{
+#pragma region DIFF
+
+	//----------------------------------------------------------------------------------------
+	PsdDiff PsdDiff::Compare(PsdData const& previous, PsdData const& current)
+	{
+		PsdDiff diff;
+		HeaderData const& before = previous.HeaderData;
+		HeaderData const& after = current.HeaderData;
+		diff.CanvasChanged = before.Width != after.Width || before.Height != after.Height
+			|| before.BitsPerPixel != after.BitsPerPixel || before.ColourMode != after.ColourMode;
+
+		// Previous layers of each name, in order.
+		std::unordered_map<std::string, std::deque<int>> previousByName;
+		std::vector<LayerData> const& previousLayers = previous.LayerMaskData.Layers;
+		for (int i = 0; i < int(previousLayers.size()); i++)
+		{
+			previousByName[previousLayers[i].LayerName].push_back(i);
+		}
+
+		std::vector<bool> matched(previousLayers.size(), false);
+		std::vector<LayerData> const& currentLayers = current.LayerMaskData.Layers;
+		for (int i = 0; i < int(currentLayers.size()); i++)
+		{
+			LayerChange change;
+			change.LayerName = currentLayers[i].LayerName;
+			change.CurrentIndex = i;
+
+			auto found = previousByName.find(change.LayerName);
+			if (found == previousByName.end() || found->second.empty())
+			{
+				change.Change = LAYER_ADDED;
+			}
+			else
+			{
+				change.PreviousIndex = found->second.front();
+				found->second.pop_front();
+				matched[change.PreviousIndex] = true;
+
+				const unsigned long long hash = currentLayers[i].ContentHash;
+				const bool same = !diff.CanvasChanged && hash != 0 && hash == previousLayers[change.PreviousIndex].ContentHash;
+				change.Change = same ? LAYER_UNCHANGED : LAYER_MODIFIED;
+			}
+			diff.Layers.push_back(change);
+		}
+
+		for (int i = 0; i < int(previousLayers.size()); i++)
+		{
+			if (matched[i]) continue;
+			LayerChange change;
+			change.LayerName = previousLayers[i].LayerName;
+			change.Change = LAYER_REMOVED;
+			change.PreviousIndex = i;
+			diff.Layers.push_back(change);
+		}
+		return diff;
+	}
+
+	//----------------------------------------------------------------------------------------
+	size_t PsdDiff::Count(LAYER_CHANGE change) const
+	{
+		return size_t(std::count_if(this->Layers.begin(), this->Layers.end(), [change](LayerChange const& layer) { return layer.Change == change; }));
+	}
+
+	//----------------------------------------------------------------------------------------
+	bool PsdDiff::IsUnchanged(std::string const& layerName) const
+	{
+		// Every layer of the name, duplicated names are only unchanged together.
+		bool found = false;
+		for (auto const& layer : this->Layers)
+		{
+			if (layer.LayerName != layerName) continue;
+			if (layer.Change != LAYER_UNCHANGED) return false;
+			found = true;
+		}
+		return found;
+	}
+
+	//----------------------------------------------------------------------------------------
+	bool PsdDiff::HasChanges() const
+	{
+		return this->CanvasChanged || Count(LAYER_UNCHANGED) != this->Layers.size();
+	}
+
+#pragma endregion
+}
@@ -0,0 +1,69 @@
+//----------------------------------------------------------------------------------------------
+// ===============================================
+//  Copyright (C) 2026, E.D. Films.
+//  All Rights Reserved.
+// ===============================================
+//  Unauthorized copying of this file, via any medium is strictly prohibited
+//  Proprietary and confidential
+//
+//  @file psdDiff.h
+//  @author Michaelson Britt
+//  @date 16-10-2026
+//
+//  @section DESCRIPTION
+//  Layers added, removed, modified or unchanged between two parsings of a document.
+//
+//----------------------------------------------------------------------------------------------
+
+#ifndef PSDDIFF_H
+#define PSDDIFF_H
+
+#include "psdReader.h"
+#include <string>
+#include <vector>
+
+namespace psd_reader
+{
+#pragma region DIFF
+
+	//----------------------------------------------------------------------------------------------
+	enum LAYER_CHANGE
+	{
+		LAYER_UNCHANGED,
+		LAYER_MODIFIED,
+		LAYER_ADDED,
+		LAYER_REMOVED
+	};
+
+	//----------------------------------------------------------------------------------------------
+	struct LayerChange
+	{
+		std::string LayerName;
+		LAYER_CHANGE Change = LAYER_UNCHANGED;
+		int PreviousIndex = -1; // In the previous LayerMaskData::Layers, -1 when added.
+		int CurrentIndex = -1; // In the current LayerMaskData::Layers, -1 when removed.
+	};
+
+	//----------------------------------------------------------------------------------------------
+	// Layers are matched by name, the n-th layer of a name with the n-th one of the same name, and
+	// compared by LayerData::ContentHash. A layer without hash is never unchanged, both documents are
+	// parsed with ReaderParameters::HashLayers, or structure only then completed with PsdReader::HashLayers.
+	class PsdDiff
+	{
+	public:
+		static PsdDiff Compare(PsdData const& previous, PsdData const& current);
+
+		// Every current layer in order, then the removed ones.
+		std::vector<LayerChange> Layers;
+		// Size, depth or color mode changed, every layer is then modified.
+		bool CanvasChanged = false;
+
+		size_t Count(LAYER_CHANGE change) const;
+		bool IsUnchanged(std::string const& layerName) const;
+		bool HasChanges() const;
+	};
+
+#pragma endregion
+}
+
+#endif // PSDDIFF_H
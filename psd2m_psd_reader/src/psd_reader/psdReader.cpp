@@ -16,6 +16,11 @@
 
 
 #include "psdReader.h"
+#include "sidecarIndex.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <utility>
 
 namespace psd_reader
 {
@@ -23,18 +28,106 @@ namespace psd_reader
 #pragma region CONSRUCTOR
 
 	//----------------------------------------------------------------------------------------
-	PsdReader::PsdReader(std::string const& pathFile)
+	PsdReader::PsdReader(std::string const& pathFile, SOURCE_BACKEND backend)
 	{
 		const char* cstrFileName(pathFile.c_str());
 		if (!DoesFileExist(cstrFileName))
 			return;
 
-		this->File = _fsopen(cstrFileName, "rb", _SH_DENYWR);
+		this->PathFile = pathFile;
+		this->Source = ByteSource::Open(pathFile, backend);
+	}
+
+	//----------------------------------------------------------------------------------------
+	PsdReader::PsdReader(const unsigned char* buffer, size_t size)
+	{
+		this->Source.reset(new MemoryByteSource(buffer, size));
 	}
 
 	//----------------------------------------------------------------------------------------
 	PsdReader::~PsdReader() = default;
 
+#pragma endregion 
+
+#pragma region PARSE HANDLE
+
+	//----------------------------------------------------------------------------------------
+	ParseHandle::ParseHandle(std::future<PsdData>&& result, CancellationToken const& cancellation, std::shared_ptr<ProgressQueue> const& queue, PsdProgress const& progress)
+		: Result(std::move(result)), Cancellation(cancellation), Queue(queue), Progress(progress)
+	{
+	}
+
+	//----------------------------------------------------------------------------------------
+	ParseHandle::ParseHandle(ParseHandle&& other)
+		: Result(std::move(other.Result)), Cancellation(std::exchange(other.Cancellation, CancellationToken())), Queue(std::move(other.Queue)), Progress(std::move(other.Progress))
+	{
+	}
+
+	//----------------------------------------------------------------------------------------
+	ParseHandle::~ParseHandle()
+	{
+		Stop();
+	}
+
+	//----------------------------------------------------------------------------------------
+	ParseHandle& ParseHandle::operator=(ParseHandle&& other)
+	{
+		if (this == &other) return *this;
+		Stop();
+		this->Result = std::move(other.Result);
+		this->Cancellation = std::exchange(other.Cancellation, CancellationToken());
+		this->Queue = std::move(other.Queue);
+		this->Progress = std::move(other.Progress);
+		return *this;
+	}
+
+	//----------------------------------------------------------------------------------------
+	void ParseHandle::Stop()
+	{
+		if (!this->Result.valid()) return;
+		Cancel();
+		this->Result.wait();
+	}
+
+	//----------------------------------------------------------------------------------------
+	bool ParseHandle::IsValid() const
+	{
+		return this->Result.valid();
+	}
+
+	//----------------------------------------------------------------------------------------
+	bool ParseHandle::IsReady() const
+	{
+		return WaitFor(std::chrono::milliseconds(0));
+	}
+
+	//----------------------------------------------------------------------------------------
+	bool ParseHandle::WaitFor(std::chrono::milliseconds timeout) const
+	{
+		return !this->Result.valid() || this->Result.wait_for(timeout) == std::future_status::ready;
+	}
+
+	//----------------------------------------------------------------------------------------
+	void ParseHandle::Cancel() const
+	{
+		this->Cancellation.Cancel();
+	}
+
+	//----------------------------------------------------------------------------------------
+	size_t ParseHandle::DrainProgress() const
+	{
+		return this->Queue != nullptr ? this->Queue->Drain(this->Progress) : 0;
+	}
+
+	//----------------------------------------------------------------------------------------
+	PsdData ParseHandle::Get()
+	{
+		if (!this->Result.valid()) return PsdData();
+		PsdData data = this->Result.get();
+		DrainProgress();
+		return data;
+	}
+
 #pragma endregion 
 
 	//----------------------------------------------------------------------------------------
@@ -44,6 +137,30 @@ namespace psd_reader
 		this->ProgressData = PsdProgress(initializeProgress, initializeSubProgress, incrementProgress, completeSubProgress);
 	}
 
+	//----------------------------------------------------------------------------------------
+	void PsdReader::SetParameters(ReaderParameters const& parameters)
+	{
+		this->Parameters = parameters;
+	}
+
+	//----------------------------------------------------------------------------------------
+	void PsdReader::SetPixelArena(std::shared_ptr<PixelArena> const& arena)
+	{
+		this->Arena = arena;
+	}
+
+	//----------------------------------------------------------------------------------------
+	void PsdReader::Cancel() const
+	{
+		this->Parameters.Cancellation.Cancel();
+	}
+
+	//----------------------------------------------------------------------------------------
+	SectionTimings const& PsdReader::GetSectionTimings() const
+	{
+		return this->Timings;
+	}
+
 	//----------------------------------------------------------------------------------------
 	bool PsdReader::DoesFileExist(const char *filename)
 	{
@@ -57,36 +174,307 @@ namespace psd_reader
 
 	//----------------------------------------------------------------------------------------
 	PsdData PsdReader::ParsePsd()
+	{
+		return Parse(this->Parameters, this->ProgressData);
+	}
+
+	//----------------------------------------------------------------------------------------
+	ParseHandle PsdReader::ParsePsdAsync()
+	{
+		// The parsing thread only uses its own copies: the parameters with a cancellation of its
+		// own, and the progress queued for the host callbacks.
+		ReaderParameters parameters = this->Parameters;
+		parameters.Cancellation = CancellationToken::LinkedTo(this->Parameters.Cancellation);
+		auto queue = std::make_shared<ProgressQueue>();
+		const PsdProgress producer = ProgressQueue::MakeProducer(queue);
+
+		std::future<PsdData> result = std::async(std::launch::async, [this, parameters, producer]()
+		{
+			return Parse(parameters, producer);
+		});
+		return ParseHandle(std::move(result), parameters.Cancellation, queue, this->ProgressData);
+	}
+
+	//----------------------------------------------------------------------------------------
+	PsdData PsdReader::Parse(ReaderParameters const& parameters, PsdProgress const& progress)
 	{
 		PsdData data;
 
-		ParseSection(data);
+		this->Timings = SectionTimings();
+		ParseSection(data, this->Timings, parameters, progress);
+		if (parameters.Cancellation.IsCancelled())
+		{
+			// Nothing partial is returned, the source is released as after a complete parsing.
+			std::cout << "Parsing PSD cancelled." << std::endl;
+			this->Source.reset();
+			return PsdData();
+		}
 		std::cout << "Parsing PSD complete." << std::endl;
-		fclose(this->File);
+
+		if (!parameters.StructureOnly)
+		{
+			this->Source.reset();
+			return data;
+		}
+
+		// Keep the source open for DecodeLayer / DecodeChannel.
+		this->LayerRecords = data.LayerMaskData.Layers;
+		this->Header = data.HeaderData;
+		this->Cache.Clear();
+		this->Cache.SetBudget(parameters.CacheBudget);
 		return data;
 	}
 
 	//----------------------------------------------------------------------------------------
-	void PsdReader::ParseSection(PsdData& data) const
+	PsdData PsdReader::ParsePreview()
 	{
-		if (this->File == nullptr) return;
+		PsdData data;
+		if (this->Source == nullptr || !this->Source->IsOpen()) return data;
 
-		if (!LoadHeader(data)) return;
-		if (!LoadColorModeData(data)) return;
-		if (!LoadImageResource(data)) return;
-		if (!LoadLayerAndMask(data)) return;
-		// Use to read the complete merged/composite image
-		// Not implemented
-		//if (!LoadImageData(data)) return;
+		// Only the sections up to the image resources are viewed, each one on its own.
+		std::vector<unsigned char> scratch;
+		BigEndianCursor cursor = ViewSection(0, HeaderReader::SIZE, scratch);
+		SectionOffsets sections;
+		if (LoadHeader(cursor, data))
+		{
+			LocateSections(data.HeaderData, sections);
+		}
+		if (sections.ImageResources != 0)
+		{
+			cursor = ViewSection(sections.ColorMode, sections.ImageResources - sections.ColorMode, scratch);
+			if (!LoadColorModeData(cursor, data)) sections.LayerAndMask = 0;
+		}
+		if (sections.LayerAndMask != 0)
+		{
+			cursor = ViewSection(sections.ImageResources, sections.LayerAndMask - sections.ImageResources, scratch);
+			LoadImageResource(cursor, data);
+		}
+		else
+		{
+			std::cout << "[PARSING PREVIEW] Error parsing the image resources" << std::endl;
+		}
+
+		this->Source.reset();
+		return data;
 	}
 
 	//----------------------------------------------------------------------------------------
-	bool PsdReader::LoadHeader(PsdData & data) const
+	ChannelPixels PsdReader::DecodeChannel(int layerIndex, short channelId)
+	{
+		if (this->Source == nullptr || layerIndex < 0 || layerIndex >= int(this->LayerRecords.size())) return nullptr;
+
+		// No pixel for user mask
+		LayerData const& layer = this->LayerRecords[layerIndex];
+		const auto found = std::find(layer.ChannelId.begin(), layer.ChannelId.end(), channelId);
+		if (found == layer.ChannelId.end() || channelId < -1) return nullptr;
+
+		const ChannelCache::Key key(layerIndex, channelId);
+		ChannelPixels pixels = this->Cache.Get(key);
+		if (pixels != nullptr) return pixels;
+
+		const auto j = size_t(found - layer.ChannelId.begin());
+		std::vector<unsigned char> scratch;
+		const unsigned char* content = this->Source->View(layer.ChannelOffset[j], size_t(layer.ChannelLength[j]), scratch);
+		if (content == nullptr) return nullptr;
+
+		const int rows = layer.AnchorBottom - layer.AnchorTop;
+		const int cols = layer.AnchorRight - layer.AnchorLeft;
+		bool corrupted = false;
+		const size_t size = LayerAndMaskReader::ChannelSize(rows, cols, this->Header.BitsPerPixel);
+		auto* decoded = static_cast<unsigned char*>(malloc(std::max<size_t>(size, 1)));
+		if (decoded == nullptr) return nullptr;
+
+		bool success = false;
+		try
+		{
+			success = LayerAndMaskReader::DecodeChannel(BigEndianCursor(content, size_t(layer.ChannelLength[j]), layer.ChannelOffset[j]), rows, cols, this->Header, decoded, corrupted, &this->Parameters.Cancellation);
+		}
+		catch (std::out_of_range const&)
+		{
+			corrupted = true;
+		}
+		catch (ParseCancelled const&)
+		{
+			success = false;
+		}
+
+		if (corrupted)
+		{
+			std::cout << "[DECODING LAYER] Corrupted data in layer " << layer.LayerName << std::endl;
+		}
+		if (!success)
+		{
+			free(decoded);
+			return nullptr;
+		}
+
+		pixels = ChannelPixels(decoded, free);
+		this->Cache.Put(key, pixels, size);
+		return pixels;
+	}
+
+	//----------------------------------------------------------------------------------------
+	std::vector<ChannelPixels> PsdReader::DecodeLayer(int layerIndex)
+	{
+		// Same order as LayerData::ImageContent.
+		std::vector<ChannelPixels> channels;
+		if (layerIndex < 0 || layerIndex >= int(this->LayerRecords.size())) return channels;
+
+		for (short channelId : this->LayerRecords[layerIndex].ChannelId)
+		{
+			if (!LayerAndMaskReader::IsChannelSelected(this->LayerRecords[layerIndex], channelId, this->Parameters)) continue;
+
+			ChannelPixels pixels = DecodeChannel(layerIndex, channelId);
+			if (pixels != nullptr) channels.push_back(pixels);
+		}
+		return channels;
+	}
+
+	//----------------------------------------------------------------------------------------
+	bool PsdReader::HashLayers(PsdData& data) const
+	{
+		if (!this->Parameters.StructureOnly || this->Source == nullptr || !this->Source->IsOpen()) return false;
+
+		SectionOffsets sections;
+		if (!LocateSections(data.HeaderData, sections)) return false;
+		std::vector<unsigned char> scratch;
+		const BigEndianCursor cursor = ViewSection(sections.LayerAndMask, sections.ImageData - sections.LayerAndMask, scratch);
+		if (cursor.Size() == 0) return false;
+		LayerAndMaskReader::HashChannels(cursor, data.LayerMaskData, this->Parameters);
+		return true;
+	}
+
+	//----------------------------------------------------------------------------------------
+	void PsdReader::ParseSection(PsdData& data, SectionTimings& timings, ReaderParameters const& parameters, PsdProgress const& progress) const
+	{
+		if (this->Source == nullptr || !this->Source->IsOpen()) return;
+
+		// Adds the time since the previous lap to seconds.
+		auto start = std::chrono::steady_clock::now();
+		auto lap = [&start](double& seconds)
+		{
+			const auto now = std::chrono::steady_clock::now();
+			seconds += std::chrono::duration<double>(now - start).count();
+			start = now;
+		};
+
+		// Each section is viewed on its own, only when it is needed: a stdio source copies what it
+		// views. The layer and merged image sections are kept for the pixels.
+		const bool compositePixels = parameters.DecodeComposite || parameters.SinglePlate;
+		const bool layerPixels = !parameters.StructureOnly && !parameters.SinglePlate;
+		std::vector<unsigned char> scratch;
+		std::vector<unsigned char> layerScratch;
+		std::vector<unsigned char> imageScratch;
+		BigEndianCursor layerCursor;
+		BigEndianCursor imageCursor;
+		SectionOffsets sections;
+
+		// The structure comes from the sidecar index when the file didn't change since it was saved.
+		const bool indexed = !this->PathFile.empty() && parameters.UseSidecarIndex;
+		const std::string indexPath = indexed ? SidecarIndex::PathFor(this->PathFile) : std::string();
+		const FileFingerprint fingerprint = indexed ? SidecarIndex::Fingerprint(this->PathFile, *this->Source) : FileFingerprint();
+		if (indexed && SidecarIndex::Load(indexPath, fingerprint, data))
+		{
+			std::cout << "[PARSING PSD] Structure loaded from " << indexPath << std::endl;
+			lap(timings.Index);
+			// Saved by a parsing without hashes, the channels are hashed now.
+			auto& layers = data.LayerMaskData.Layers;
+			const bool hashes = parameters.HashLayers && std::any_of(layers.begin(), layers.end(), [](LayerData const& layer) { return layer.ContentHash == 0; });
+			if (!compositePixels && !layerPixels && !hashes) return;
+			if (!LocateSections(data.HeaderData, sections)) return;
+			lap(timings.Source);
+			if (layerPixels || hashes) layerCursor = ViewSection(sections.LayerAndMask, sections.ImageData - sections.LayerAndMask, layerScratch);
+			if (compositePixels) imageCursor = ViewSection(sections.ImageData, this->Source->Size(), imageScratch);
+			if (hashes)
+			{
+				LayerAndMaskReader::HashChannels(layerCursor, data.LayerMaskData, parameters);
+				lap(timings.LayerStructure);
+			}
+		}
+		else
+		{
+			BigEndianCursor cursor = ViewSection(0, HeaderReader::SIZE, scratch);
+			lap(timings.Source);
+			if (!LoadHeader(cursor, data) || parameters.Cancellation.IsCancelled()) return;
+			lap(timings.Header);
+			if (!LocateSections(data.HeaderData, sections)) return;
+			lap(timings.Source);
+			cursor = ViewSection(sections.ColorMode, sections.ImageResources - sections.ColorMode, scratch);
+			if (!LoadColorModeData(cursor, data) || parameters.Cancellation.IsCancelled()) return;
+			lap(timings.ColorMode);
+			cursor = ViewSection(sections.ImageResources, sections.LayerAndMask - sections.ImageResources, scratch);
+			if (!LoadImageResource(cursor, data) || parameters.Cancellation.IsCancelled()) return;
+			lap(timings.ImageResources);
+			layerCursor = ViewSection(sections.LayerAndMask, sections.ImageData - sections.LayerAndMask, layerScratch);
+			BigEndianCursor layerSection = layerCursor;
+			if (!LoadLayerAndMask(layerSection, data, parameters) || parameters.Cancellation.IsCancelled()) return;
+			lap(timings.LayerStructure);
+			// The merged image is optional, the layers are kept without it. Its compression only
+			// unless its pixels are decoded.
+			imageCursor = ViewSection(sections.ImageData, compositePixels ? this->Source->Size() : 2, imageScratch);
+			BigEndianCursor imageSection = imageCursor;
+			LoadImageData(imageSection, data);
+
+			if (indexed) SidecarIndex::Save(indexPath, fingerprint, data);
+			lap(timings.ImageData);
+		}
+
+		if (compositePixels) LoadCompositePixels(imageCursor, data, parameters);
+		lap(timings.Composite);
+		if (parameters.Cancellation.IsCancelled()) return;
+		if (layerPixels)
+		{
+			data.LayerMaskData.Pixels = this->Arena;
+			LoadLayerPixels(layerCursor, data, parameters, progress);
+			lap(timings.LayerPixels);
+		}
+	}
+
+	//----------------------------------------------------------------------------------------
+	// Cursor on [offset, offset + size) of the source, cut at the end of the file. Its Offset()
+	// counts from the start of the file, as the offsets kept in the structure.
+	BigEndianCursor PsdReader::ViewSection(unsigned long long offset, unsigned long long size, std::vector<unsigned char>& scratch) const
+	{
+		const unsigned long long fileSize = this->Source->Size();
+		if (offset > fileSize) return BigEndianCursor();
+		size = std::min(size, fileSize - offset);
+		const unsigned char* content = this->Source->View(offset, size_t(size), scratch);
+		return content != nullptr ? BigEndianCursor(content, size_t(size), offset) : BigEndianCursor();
+	}
+
+	//----------------------------------------------------------------------------------------
+	// Only the lengths in front of the sections are viewed, a few bytes each.
+	bool PsdReader::LocateSections(HeaderData const& header, SectionOffsets& sections) const
+	{
+		const unsigned long long fileSize = this->Source->Size();
+		std::vector<unsigned char> scratch;
+		try
+		{
+			sections.ColorMode = HeaderReader::SIZE;
+			sections.ImageResources = sections.ColorMode + 4 + ViewSection(sections.ColorMode, 4, scratch).Read<unsigned int>();
+			sections.LayerAndMask = sections.ImageResources + 4 + ViewSection(sections.ImageResources, 4, scratch).Read<unsigned int>();
+
+			const unsigned lengthSize = header.IsLargeDocument() ? 8 : 4;
+			BigEndianCursor length = ViewSection(sections.LayerAndMask, lengthSize, scratch);
+			const unsigned long long layerLength = header.ReadLength(length);
+			if (layerLength > fileSize) throw std::out_of_range("PsdReader: layer and mask section past the end of the file");
+			sections.ImageData = sections.LayerAndMask + lengthSize + layerLength;
+		}
+		catch (std::out_of_range const&)
+		{
+			std::cout << "[PARSING PSD] Error locating the sections" << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	//----------------------------------------------------------------------------------------
+	bool PsdReader::LoadHeader(BigEndianCursor& cursor, PsdData& data) const
 	{
 		bool success;	// No errors
 		try
 		{
-			success = HeaderReader::Read(this->File, data.HeaderData);
+			success = HeaderReader::Read(cursor, data.HeaderData);
 			if (!success)
 			{
 				std::cout << "[PARSING HEADER] Error parsing Header" << std::endl;
@@ -101,12 +489,12 @@ namespace psd_reader
 	}
 
 	//----------------------------------------------------------------------------------------
-	bool PsdReader::LoadColorModeData(PsdData & data) const
+	bool PsdReader::LoadColorModeData(BigEndianCursor& cursor, PsdData& data) const
 	{
 		bool success;	// No errors
 		try
 		{
-			success = ColorModeReader::Read(this->File, data.ColorModeData);
+			success = ColorModeReader::Read(cursor, data.ColorModeData);
 			if (!success)
 			{
 				std::cout << "[PARSING COLOR MODE] Error parsing Color Mode" << std::endl;
@@ -121,12 +509,12 @@ namespace psd_reader
 	}
 
 	//----------------------------------------------------------------------------------------
-	bool PsdReader::LoadImageResource(PsdData & data) const
+	bool PsdReader::LoadImageResource(BigEndianCursor& cursor, PsdData& data) const
 	{
 		bool success;	// No errors
 		try
 		{
-			success = ImageResourceReader::Read(this->File, data.ImageResourceData);
+			success = ImageResourceReader::Read(cursor, data.ImageResourceData);
 			if (!success)
 			{
 				std::cout << "[PARSING IMAGE RESOURCE] Error parsing Image resource" << std::endl;
@@ -141,16 +529,60 @@ namespace psd_reader
 	}
 
 	//----------------------------------------------------------------------------------------
-	bool PsdReader::LoadLayerAndMask(PsdData & data) const
+	bool PsdReader::LoadLayerAndMask(BigEndianCursor& cursor, PsdData& data, ReaderParameters const& parameters) const
 	{
 		bool success;	// No errors
 		try
 		{
-			success = LayerAndMaskReader::Read(this->File, data.HeaderData, data.LayerMaskData, this->ProgressData);
+			success = LayerAndMaskReader::Read(cursor, data.HeaderData, data.LayerMaskData);
 			if (!success)
 			{
 				std::cout << "[PARSING LAYER AND MASK] Error parsing Layer Mask data" << std::endl;
 			}
+			else if (parameters.HashLayers)
+			{
+				LayerAndMaskReader::HashChannels(cursor, data.LayerMaskData, parameters);
+			}
+		}
+		catch (...)
+		{
+			success = false;
+		}
+
+		return success;
+	}
+
+	//----------------------------------------------------------------------------------------
+	bool PsdReader::LoadLayerPixels(BigEndianCursor const& cursor, PsdData& data, ReaderParameters const& parameters, PsdProgress const& progress) const
+	{
+		bool success;	// No errors
+		try
+		{
+			success = LayerAndMaskReader::DecodeChannels(cursor, data.HeaderData, data.LayerMaskData, progress, parameters);
+			if (!success)
+			{
+				std::cout << "[PARSING LAYER PIXELS] Error decoding Layer pixels" << std::endl;
+			}
+		}
+		catch (...)
+		{
+			success = false;
+		}
+
+		return success;
+	}
+
+	//----------------------------------------------------------------------------------------
+	bool PsdReader::LoadCompositePixels(BigEndianCursor const& cursor, PsdData& data, ReaderParameters const& parameters) const
+	{
+		bool success;	// No errors
+		try
+		{
+			success = ImageDataReader::Decode(cursor, data.ImageData, data.HeaderData, parameters);
+			if (!success)
+			{
+				std::cout << "[PARSING IMAGE DATA] Error decoding merged image" << std::endl;
+			}
 		}
 		catch (...)
 		{
@@ -161,12 +593,12 @@ namespace psd_reader
 	}
 
 	//----------------------------------------------------------------------------------------
-	bool PsdReader::LoadImageData(PsdData & data) const
+	bool PsdReader::LoadImageData(BigEndianCursor& cursor, PsdData& data) const
 	{
 		bool success;	// No errors
 		try
 		{
-			success = ImageDataReader::Read(this->File, data.ImageData, data.ImageResourceData.ResolutionInfo, data.HeaderData);
+			success = ImageDataReader::Read(cursor, data.ImageData, data.HeaderData);
 			if (!success)
 			{
 				std::cout << "[PARSING IMAGE DATA] Error parsing Image data" << std::endl;
@@ -22,8 +22,13 @@
 #include "imageResourceReader.h"
 #include "layerAndMaskReader.h"
 #include "imageDataReader.h"
+#include "byteSource.h"
+#include "channelCache.h"
 #include "progress.h"
+#include <chrono>
 #include <functional>
+#include <future>
+#include <memory>
 using namespace util;
 
 namespace psd_reader
@@ -40,30 +45,134 @@ namespace psd_reader
 		ImageData ImageData;
 	};
 
+	//----------------------------------------------------------------------------------------------
+	// Seconds spent in each part of the last ParsePsd, zero for the parts it skipped.
+	//----------------------------------------------------------------------------------------------
+	struct SectionTimings
+	{
+		double Source = 0; // Viewing the header and the lengths of the sections.
+		double Index = 0; // Sidecar index, replaces the header to the image data structure.
+		double Header = 0;
+		double ColorMode = 0;
+		double ImageResources = 0;
+		double LayerStructure = 0;
+		double ImageData = 0; // Structure of the merged image.
+		double Composite = 0;
+		double LayerPixels = 0;
+
+		double Total() const
+		{
+			return Source + Index + Header + ColorMode + ImageResources + LayerStructure + ImageData + Composite + LayerPixels;
+		}
+	};
+
+	//----------------------------------------------------------------------------------------------
+	// Parsing running on another thread, see PsdReader::ParsePsdAsync. Every method is meant for
+	// the host thread. Destroying a running handle cancels the parsing and waits for it.
+	//----------------------------------------------------------------------------------------------
+	class ParseHandle
+	{
+	public:
+		ParseHandle() = default;
+		ParseHandle(std::future<PsdData>&& result, CancellationToken const& cancellation, std::shared_ptr<ProgressQueue> const& queue, PsdProgress const& progress);
+		// The handle moved from is left empty, its cancellation no longer reaches the parsing.
+		ParseHandle(ParseHandle&& other);
+		ParseHandle(ParseHandle const&) = delete;
+		// The running parsing of this handle, if any, is cancelled and waited for before taking the other.
+		ParseHandle& operator=(ParseHandle&& other);
+		ParseHandle& operator=(ParseHandle const&) = delete;
+		~ParseHandle();
+
+		bool IsValid() const;
+		bool IsReady() const;
+		// True when the parsing is over, false after timeout.
+		bool WaitFor(std::chrono::milliseconds timeout) const;
+		void Cancel() const;
+		// Replays the progress queued by the parsing on the callbacks given to PsdReader::SetProgress.
+		size_t DrainProgress() const;
+		// Waits for the end of the parsing, once. Empty data when cancelled.
+		PsdData Get();
+
+	private:
+		std::future<PsdData> Result;
+		CancellationToken Cancellation;
+		std::shared_ptr<ProgressQueue> Queue;
+		PsdProgress Progress;
+
+		void Stop();
+	};
+
 	//----------------------------------------------------------------------------------------------
 	class PsdReader
 	{
 	public:
-		PsdReader(std::string const& pathFile);
+		PsdReader(std::string const& pathFile, SOURCE_BACKEND backend = MAPPED_SOURCE);
+		PsdReader(const unsigned char* buffer, size_t size);
 		virtual	~PsdReader();
 		void SetProgress(std::function<void(unsigned)>& initializeProgress, std::function<void(unsigned)>& initializeSubProgress, std::function<
 		                 void()>& incrementProgress, std::function<void()>& completeSubProgress);
+		void SetParameters(ReaderParameters const& parameters);
+
+		// Layer pixels are decoded into this arena, typically the one of the previous parsing of the
+		// same document, whose pixels are then overwritten or freed: only pass an arena nothing reads
+		// from any more. A new arena is made when none is set.
+		void SetPixelArena(std::shared_ptr<PixelArena> const& arena);
 		PsdData ParsePsd();
+		// ParsePsd on a new thread. The reader must outlive the handle and stay untouched until
+		// ParseHandle::Get returns, the progress callbacks run where DrainProgress is called.
+		// The parsing has its own cancellation, linked to ReaderParameters::Cancellation.
+		ParseHandle ParsePsdAsync();
+		// Header, color mode and image resources only, for ImageResourceData::Thumbnail. Nothing
+		// past the image resources is read, the layers and the merged image are left empty.
+		PsdData ParsePreview();
+		// Abort ParsePsd from another thread, same as cancelling ReaderParameters::Cancellation.
+		void Cancel() const;
+		SectionTimings const& GetSectionTimings() const;
+
+		// Decoding on demand after a structure only parsing, see ReaderParameters::StructureOnly.
+		// DecodeLayer only decodes the channels selected by the parameters, DecodeChannel any of them.
+		ChannelPixels DecodeChannel(int layerIndex, short channelId);
+		std::vector<ChannelPixels> DecodeLayer(int layerIndex);
+		// LayerData::ContentHash of data parsed by this reader without ReaderParameters::HashLayers,
+		// reads the compressed bytes of every channel. Only after a structure only parsing, the
+		// file is released after the others: set ReaderParameters::HashLayers for them instead.
+		// False when the layers couldn't be read.
+		bool HashLayers(PsdData& data) const;
 
 	private:
+		// Start of each section after the header, 0 when it couldn't be located.
+		struct SectionOffsets
+		{
+			unsigned long long ColorMode = 0;
+			unsigned long long ImageResources = 0;
+			unsigned long long LayerAndMask = 0;
+			unsigned long long ImageData = 0;
+		};
 
-		FILE* File;
+		std::string PathFile; // Empty when reading from memory, no sidecar index then.
+		std::unique_ptr<ByteSource> Source;
 		PsdProgress ProgressData;
+		ReaderParameters Parameters;
+		std::shared_ptr<PixelArena> Arena;
+		std::vector<LayerData> LayerRecords; // Layers structure kept for the decoding on demand.
+		HeaderData Header; // Depth and version of the file for the decoding on demand.
+		ChannelCache Cache;
+		SectionTimings Timings;
 
 		static bool DoesFileExist(const char* filename);
 		
 		
-        void ParseSection(PsdData & data) const;
-		bool LoadHeader(PsdData & data) const;
-		bool LoadColorModeData(PsdData & data) const;
-		bool LoadImageResource(PsdData & data) const;
-		bool LoadLayerAndMask(PsdData& data) const;
-		bool LoadImageData(PsdData & data) const;
+		PsdData Parse(ReaderParameters const& parameters, PsdProgress const& progress);
+        void ParseSection(PsdData & data, SectionTimings& timings, ReaderParameters const& parameters, PsdProgress const& progress) const;
+		BigEndianCursor ViewSection(unsigned long long offset, unsigned long long size, std::vector<unsigned char>& scratch) const;
+		bool LocateSections(HeaderData const& header, SectionOffsets& sections) const;
+		bool LoadHeader(BigEndianCursor& cursor, PsdData& data) const;
+		bool LoadColorModeData(BigEndianCursor& cursor, PsdData& data) const;
+		bool LoadImageResource(BigEndianCursor& cursor, PsdData& data) const;
+		bool LoadLayerAndMask(BigEndianCursor& cursor, PsdData& data, ReaderParameters const& parameters) const;
+		bool LoadLayerPixels(BigEndianCursor const& cursor, PsdData& data, ReaderParameters const& parameters, PsdProgress const& progress) const;
+		bool LoadCompositePixels(BigEndianCursor const& cursor, PsdData& data, ReaderParameters const& parameters) const;
+		bool LoadImageData(BigEndianCursor& cursor, PsdData& data) const;
 	};
 }
 
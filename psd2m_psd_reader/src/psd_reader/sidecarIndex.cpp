@@ -0,0 +1,401 @@
+//----------------------------------------------------------------------------------------------
+// ===============================================
+//  Copyright (C) 2026, E.D. Films.
+//  All Rights Reserved.
+// ===============================================
+//  Unauthorized copying of this file, via any medium is strictly prohibited
+//  Proprietary and confidential
+//
+//  @file sidecarIndex.cpp
+//  @author Michaelson Britt
+//  @date 16-10-2026
+//
+//  @section DESCRIPTION
+//
+//----------------------------------------------------------------------------------------------
+
+#include "sidecarIndex.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <sys/stat.h>
+#include "util/bigEndianCursor.h"
+
+using namespace util;
+
+namespace psd_reader
+{
+	//----------------------------------------------------------------------------------------
+	const unsigned int SidecarIndex::VERSION(6);
+
+	static const std::string INDEX_SIGNATURE = "PSDX";
+	static const std::string INDEX_FILE = "structure.idx";
+	static const size_t SAMPLE_COUNT = 16;
+	static const size_t SAMPLE_SIZE = 4096;
+
+	//----------------------------------------------------------------------------------------
+	// Big-endian output, the counterpart of BigEndianCursor.
+	class IndexWriter
+	{
+	public:
+		std::vector<unsigned char> Bytes;
+
+		template <typename T>
+		void Write(T value)
+		{
+			for (int shift = int(sizeof(T) - 1) * 8; shift >= 0; shift -= 8)
+			{
+				this->Bytes.push_back(static_cast<unsigned char>((static_cast<unsigned long long>(value) >> shift) & 0xFF));
+			}
+		}
+
+		void WriteFloat(float value)
+		{
+			unsigned int bits;
+			memcpy(&bits, &value, sizeof(bits));
+			Write<unsigned int>(bits);
+		}
+
+		void WriteBytes(const unsigned char* data, size_t size)
+		{
+			this->Bytes.insert(this->Bytes.end(), data, data + size);
+		}
+
+		void WriteString(std::string const& value)
+		{
+			Write<unsigned int>(unsigned(value.size()));
+			WriteBytes(reinterpret_cast<const unsigned char*>(value.data()), value.size());
+		}
+	};
+
+	//----------------------------------------------------------------------------------------
+	static float ReadFloat(BigEndianCursor& cursor)
+	{
+		const auto bits = cursor.Read<unsigned int>();
+		float value;
+		memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+
+	//----------------------------------------------------------------------------------------
+	static std::string ReadString(BigEndianCursor& cursor)
+	{
+		const auto size = cursor.Read<unsigned int>();
+		const auto text = reinterpret_cast<const char*>(cursor.Take(size));
+		return std::string(text, size);
+	}
+
+	//----------------------------------------------------------------------------------------
+	static void WritePaths(IndexWriter& writer, PathStore const& paths)
+	{
+		writer.Write<unsigned int>(unsigned(paths.Size()));
+		for (PathView path : paths)
+		{
+			writer.Write<unsigned char>(path.IsClosedPath ? 1 : 0);
+			writer.Write<unsigned int>(unsigned(path.Size()));
+			for (size_t i = 0; i < path.Size(); i++)
+			{
+				writer.Write<unsigned char>(path.IsLinked(i) ? 1 : 0);
+				writer.WriteFloat(path.AnchorPoint(i).x);
+				writer.WriteFloat(path.AnchorPoint(i).y);
+				writer.WriteFloat(path.SegIn(i).x);
+				writer.WriteFloat(path.SegIn(i).y);
+				writer.WriteFloat(path.SegOut(i).x);
+				writer.WriteFloat(path.SegOut(i).y);
+			}
+		}
+	}
+
+	//----------------------------------------------------------------------------------------
+	static void ReadPaths(BigEndianCursor& cursor, PathStore& paths)
+	{
+		const auto pathCount = cursor.Read<unsigned int>();
+		for (unsigned int i = 0; i < pathCount; i++)
+		{
+			paths.BeginPath(cursor.Read<unsigned char>() != 0);
+			const auto pointCount = cursor.Read<unsigned int>();
+			for (unsigned int j = 0; j < pointCount; j++)
+			{
+				PathPoints point;
+				point.IsLinked = cursor.Read<unsigned char>() != 0;
+				point.AnchorPoint.x = ReadFloat(cursor);
+				point.AnchorPoint.y = ReadFloat(cursor);
+				point.SegIn.x = ReadFloat(cursor);
+				point.SegIn.y = ReadFloat(cursor);
+				point.SegOut.x = ReadFloat(cursor);
+				point.SegOut.y = ReadFloat(cursor);
+				paths.AddPoint(point);
+			}
+		}
+		paths.EndPath();
+	}
+
+	//----------------------------------------------------------------------------------------
+	std::string SidecarIndex::PathFor(std::string const& psdPath)
+	{
+		// Same folder as the plugin output: the directory of the psd, then the name up to the first dot.
+		const auto slash = psdPath.find_last_of("/\\");
+		const std::string directory = slash == std::string::npos ? "." : psdPath.substr(0, slash);
+		const std::string fileName = slash == std::string::npos ? psdPath : psdPath.substr(slash + 1);
+		const std::string baseName = fileName.substr(0, fileName.find('.'));
+		return directory + "/" + baseName + "/" + INDEX_FILE;
+	}
+
+	//----------------------------------------------------------------------------------------
+	FileFingerprint SidecarIndex::Fingerprint(std::string const& psdPath, ByteSource const& source)
+	{
+		FileFingerprint fingerprint;
+		fingerprint.Size = source.Size();
+
+#ifdef _WIN32
+		struct _stat64 status;
+		if (_stat64(psdPath.c_str(), &status) == 0) fingerprint.ModifiedTime = status.st_mtime;
+#else
+		struct stat status;
+		if (stat(psdPath.c_str(), &status) == 0) fingerprint.ModifiedTime = status.st_mtime;
+#endif
+
+		// FNV-1a over blocks evenly spread from the header to the last bytes.
+		unsigned long long hash = 14695981039346656037ull;
+		std::vector<unsigned char> scratch;
+		const unsigned long long sampleSize = std::min<unsigned long long>(SAMPLE_SIZE, fingerprint.Size);
+		const unsigned long long span = fingerprint.Size - sampleSize;
+		for (size_t i = 0; i < SAMPLE_COUNT && sampleSize > 0; i++)
+		{
+			const unsigned long long offset = span * i / (SAMPLE_COUNT - 1);
+			const unsigned char* sample = source.View(offset, size_t(sampleSize), scratch);
+			if (sample == nullptr) break;
+
+			for (size_t j = 0; j < sampleSize; j++)
+			{
+				hash = (hash ^ sample[j]) * 1099511628211ull;
+			}
+		}
+		fingerprint.SampleHash = hash;
+		return fingerprint;
+	}
+
+	//----------------------------------------------------------------------------------------
+	bool SidecarIndex::Save(std::string const& indexPath, FileFingerprint const& fingerprint, PsdData const& data)
+	{
+		IndexWriter writer;
+		writer.WriteBytes(reinterpret_cast<const unsigned char*>(INDEX_SIGNATURE.data()), INDEX_SIGNATURE.size());
+		writer.Write<unsigned int>(VERSION);
+		writer.Write<unsigned long long>(fingerprint.Size);
+		writer.Write<long long>(fingerprint.ModifiedTime);
+		writer.Write<unsigned long long>(fingerprint.SampleHash);
+
+		// Header
+		HeaderData const& header = data.HeaderData;
+		writer.Write<short>(header.Version);
+		writer.Write<short>(header.Channels);
+		writer.Write<int>(header.Height);
+		writer.Write<int>(header.Width);
+		writer.Write<short>(header.BitsPerPixel);
+		writer.Write<short>(header.ColourMode);
+
+		// Color mode
+		const int colorLength = data.ColorModeData.ColorData != nullptr ? data.ColorModeData.Length : 0;
+		writer.Write<int>(data.ColorModeData.Length);
+		writer.Write<int>(colorLength);
+		if (colorLength > 0) writer.WriteBytes(data.ColorModeData.ColorData, colorLength);
+
+		// Image resources
+		ImageResourceData const& resources = data.ImageResourceData;
+		writer.Write<int>(resources.Length);
+		writer.Write<short>(resources.ResolutionInfo.HRes);
+		writer.Write<int>(resources.ResolutionInfo.HResUnit);
+		writer.Write<short>(resources.ResolutionInfo.WidthUnit);
+		writer.Write<short>(resources.ResolutionInfo.VRes);
+		writer.Write<int>(resources.ResolutionInfo.VResUnit);
+		writer.Write<short>(resources.ResolutionInfo.HeightUnit);
+		writer.Write<int>(resources.Thumbnail.Width);
+		writer.Write<int>(resources.Thumbnail.Height);
+		writer.Write<unsigned int>(unsigned(resources.Thumbnail.Rgba.size()));
+		writer.WriteBytes(resources.Thumbnail.Rgba.data(), resources.Thumbnail.Rgba.size());
+		writer.Write<unsigned int>(unsigned(resources.ResourceBlockPaths.size()));
+		for (auto const& block : resources.ResourceBlockPaths)
+		{
+			writer.WriteString(block.Name);
+			WritePaths(writer, block.PathRecords);
+		}
+
+		// Layer records
+		LayerAndMaskData const& layerMask = data.LayerMaskData;
+		writer.Write<short>(layerMask.LayerCount);
+		writer.Write<unsigned int>(unsigned(layerMask.Layers.size()));
+		for (auto const& layer : layerMask.Layers)
+		{
+			writer.WriteString(layer.LayerName);
+			writer.Write<int>(layer.Type);
+			writer.Write<int>(layer.AnchorTop);
+			writer.Write<int>(layer.AnchorRight);
+			writer.Write<int>(layer.AnchorBottom);
+			writer.Write<int>(layer.AnchorLeft);
+			writer.Write<int>(layer.NbrChannel);
+			writer.Write<unsigned long long>(layer.RecordHash);
+			writer.Write<unsigned long long>(layer.ContentHash);
+			for (int j = 0; j < layer.NbrChannel; j++)
+			{
+				writer.Write<short>(layer.ChannelId[j]);
+				writer.Write<unsigned long long>(layer.ChannelLength[j]);
+				writer.Write<unsigned long long>(j < int(layer.ChannelOffset.size()) ? layer.ChannelOffset[j] : 0);
+				writer.Write<short>(j < int(layer.ChannelCompression.size()) ? layer.ChannelCompression[j] : short(-1));
+			}
+			WritePaths(writer, layer.PathRecords);
+		}
+
+		// Merged image
+		writer.Write<unsigned long long>(data.ImageData.Offset);
+		writer.Write<short>(data.ImageData.Compression);
+		writer.Write<int>(data.ImageData.Width);
+		writer.Write<int>(data.ImageData.Height);
+		writer.Write<short>(data.ImageData.BitsPerPixel);
+
+		// Written aside then renamed, a reader never sees a partial index.
+		const std::string temporaryPath = indexPath + ".tmp";
+		FILE* file = fopen(temporaryPath.c_str(), "wb");
+		if (file == nullptr) return false;
+
+		const bool written = fwrite(writer.Bytes.data(), 1, writer.Bytes.size(), file) == writer.Bytes.size();
+		fclose(file);
+		remove(indexPath.c_str());
+		if (!written || rename(temporaryPath.c_str(), indexPath.c_str()) != 0)
+		{
+			remove(temporaryPath.c_str());
+			return false;
+		}
+		return true;
+	}
+
+	//----------------------------------------------------------------------------------------
+	bool SidecarIndex::Load(std::string const& indexPath, FileFingerprint const& fingerprint, PsdData& data)
+	{
+		FILE* file = fopen(indexPath.c_str(), "rb");
+		if (file == nullptr) return false;
+
+		std::vector<unsigned char> content;
+		unsigned char buffer[65536];
+		for (size_t count = fread(buffer, 1, sizeof(buffer), file); count > 0; count = fread(buffer, 1, sizeof(buffer), file))
+		{
+			content.insert(content.end(), buffer, buffer + count);
+		}
+		fclose(file);
+
+		// Everything is read aside and only given to data once the whole index is valid.
+		HeaderData header;
+		int colorModeLength;
+		std::vector<unsigned char> colorData;
+		ImageResourceData resources;
+		LayerAndMaskData layerMask;
+		ImageData imageData;
+		try
+		{
+			BigEndianCursor cursor(content.data(), content.size());
+			if (cursor.ReadKey() != INDEX_SIGNATURE || cursor.Read<unsigned int>() != VERSION) return false;
+
+			FileFingerprint stored;
+			stored.Size = cursor.Read<unsigned long long>();
+			stored.ModifiedTime = cursor.Read<long long>();
+			stored.SampleHash = cursor.Read<unsigned long long>();
+			if (!(stored == fingerprint)) return false;
+
+			// Header
+			header.Version = cursor.Read<short>();
+			header.Channels = cursor.Read<short>();
+			header.Height = cursor.Read<int>();
+			header.Width = cursor.Read<int>();
+			header.BitsPerPixel = cursor.Read<short>();
+			header.ColourMode = cursor.Read<short>();
+
+			// Color mode
+			colorModeLength = cursor.Read<int>();
+			const int colorLength = cursor.Read<int>();
+			if (colorLength > 0)
+			{
+				colorData.resize(size_t(colorLength));
+				cursor.ReadBytes(colorData.data(), colorData.size());
+			}
+
+			// Image resources
+			resources.Length = cursor.Read<int>();
+			resources.ResolutionInfo.HRes = cursor.Read<short>();
+			resources.ResolutionInfo.HResUnit = cursor.Read<int>();
+			resources.ResolutionInfo.WidthUnit = cursor.Read<short>();
+			resources.ResolutionInfo.VRes = cursor.Read<short>();
+			resources.ResolutionInfo.VResUnit = cursor.Read<int>();
+			resources.ResolutionInfo.HeightUnit = cursor.Read<short>();
+			resources.Thumbnail.Width = cursor.Read<int>();
+			resources.Thumbnail.Height = cursor.Read<int>();
+			const auto thumbnailSize = cursor.Read<unsigned int>();
+			if (thumbnailSize > cursor.Remaining()) throw std::out_of_range("Truncated thumbnail");
+			resources.Thumbnail.Rgba.resize(thumbnailSize);
+			if (thumbnailSize > 0) cursor.ReadBytes(resources.Thumbnail.Rgba.data(), thumbnailSize);
+			const auto blockCount = cursor.Read<unsigned int>();
+			for (unsigned int i = 0; i < blockCount; i++)
+			{
+				ResourceBlockPath block;
+				block.Name = ReadString(cursor);
+				ReadPaths(cursor, block.PathRecords);
+				resources.ResourceBlockPaths.push_back(block);
+			}
+
+			// Layer records
+			layerMask.LayerCount = cursor.Read<short>();
+			const auto layerCount = cursor.Read<unsigned int>();
+			for (unsigned int i = 0; i < layerCount; i++)
+			{
+				LayerData layer;
+				layer.LayerName = ReadString(cursor);
+				layer.Type = static_cast<TYPE_LAYER>(cursor.Read<int>());
+				layer.AnchorTop = cursor.Read<int>();
+				layer.AnchorRight = cursor.Read<int>();
+				layer.AnchorBottom = cursor.Read<int>();
+				layer.AnchorLeft = cursor.Read<int>();
+				layer.NbrChannel = cursor.Read<int>();
+				layer.RecordHash = cursor.Read<unsigned long long>();
+				layer.ContentHash = cursor.Read<unsigned long long>();
+				for (int j = 0; j < layer.NbrChannel; j++)
+				{
+					layer.ChannelId.push_back(cursor.Read<short>());
+					layer.ChannelLength.push_back(cursor.Read<unsigned long long>());
+					layer.ChannelOffset.push_back(cursor.Read<unsigned long long>());
+					layer.ChannelCompression.push_back(cursor.Read<short>());
+				}
+				ReadPaths(cursor, layer.PathRecords);
+				layerMask.Layers.push_back(layer);
+			}
+
+			// Merged image
+			imageData.Offset = cursor.Read<unsigned long long>();
+			imageData.Compression = cursor.Read<short>();
+			imageData.Width = cursor.Read<int>();
+			imageData.Height = cursor.Read<int>();
+			imageData.BitsPerPixel = cursor.Read<short>();
+
+			if (!cursor.AtEnd()) return false;
+		}
+		catch (std::out_of_range const&)
+		{
+			return false;
+		}
+
+		data.HeaderData = header;
+		delete[] data.ColorModeData.ColorData;
+		data.ColorModeData.ColorData = nullptr;
+		data.ColorModeData.Length = colorModeLength;
+		if (!colorData.empty())
+		{
+			data.ColorModeData.ColorData = new unsigned char[colorData.size()];
+			memcpy(data.ColorModeData.ColorData, colorData.data(), colorData.size());
+		}
+		data.ImageResourceData = resources;
+		data.ImageResourceData.BuildIndex();
+		data.LayerMaskData.LayerCount = layerMask.LayerCount;
+		data.LayerMaskData.Layers = layerMask.Layers;
+		data.LayerMaskData.BuildIndex();
+		data.ImageData = imageData;
+		return true;
+	}
+}
@@ -0,0 +1,68 @@
+//----------------------------------------------------------------------------------------------
+// ===============================================
+//  Copyright (C) 2026, E.D. Films.
+//  All Rights Reserved.
+// ===============================================
+//  Unauthorized copying of this file, via any medium is strictly prohibited
+//  Proprietary and confidential
+//
+//  @file sidecarIndex.h
+//  @author Michaelson Britt
+//  @date 16-10-2026
+//
+//  @section DESCRIPTION
+//  Parsed structure of a PSD saved next to its output folder, reused while the file is unchanged.
+//
+//----------------------------------------------------------------------------------------------
+
+#ifndef SIDECARINDEX_H
+#define SIDECARINDEX_H
+
+#include <string>
+#include "byteSource.h"
+#include "psdReader.h"
+
+namespace psd_reader
+{
+#pragma region DATA
+
+	//----------------------------------------------------------------------------------------------
+	// Cheap identity of a file: size, modification time and a hash of samples spread over the content.
+	struct FileFingerprint
+	{
+		unsigned long long Size = 0;
+		long long ModifiedTime = 0;
+		unsigned long long SampleHash = 0;
+
+		bool operator==(FileFingerprint const& other) const
+		{
+			return Size == other.Size && ModifiedTime == other.ModifiedTime && SampleHash == other.SampleHash;
+		}
+	};
+
+#pragma endregion
+
+#pragma region INDEX
+
+	//----------------------------------------------------------------------------------------------
+	class SidecarIndex
+	{
+	public:
+		// <folder of the psd>/<name of the psd>/structure.idx, beside parameters.json.
+		static std::string PathFor(std::string const& psdPath);
+		static FileFingerprint Fingerprint(std::string const& psdPath, ByteSource const& source);
+
+		// Header, color mode, image resources, layer records and merged image position, without pixels.
+		// Nothing is written when the output folder doesn't exist.
+		static bool Save(std::string const& indexPath, FileFingerprint const& fingerprint, PsdData const& data);
+		// False if the index is missing, corrupted or made for another version of the file.
+		static bool Load(std::string const& indexPath, FileFingerprint const& fingerprint, PsdData& data);
+
+	private:
+		static const unsigned int VERSION;
+	};
+
+#pragma endregion
+}
+
+#endif // SIDECARINDEX_H
@@ -0,0 +1,149 @@
+//----------------------------------------------------------------------------------------------
+// ===============================================
+//  Copyright (C) 2026, E.D. Films.
+//  All Rights Reserved.
+// ===============================================
+//  Unauthorized copying of this file, via any medium is strictly prohibited
+//  Proprietary and confidential
+//
+//  @file bigEndianCursor.h
+//  @author Michaelson Britt
+//  @date 16-10-2026
+//
+//  @section DESCRIPTION
+//  Bounds-checked reader over a big-endian buffer. Sub() narrows the cursor to a section so
+//  a malformed length can't read past the section it belongs to.
+//
+//----------------------------------------------------------------------------------------------
+
+#ifndef BIGENDIANCURSOR_H
+#define BIGENDIANCURSOR_H
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+namespace util
+{
+	//----------------------------------------------------------------------------------------------
+	class BigEndianCursor
+	{
+	public:
+		BigEndianCursor() = default;
+		BigEndianCursor(const unsigned char* data, size_t length, unsigned long long origin = 0)
+			: Begin(data), Length(data == nullptr ? 0 : length), Origin(origin) {}
+
+		//----------------------------------------------------------------------------------------------
+		template<typename T>
+		T Read()
+		{
+			static_assert(std::is_integral<T>::value, "BigEndianCursor::Read expects an integral type");
+			typedef typename std::make_unsigned<T>::type Unsigned;
+
+			const unsigned char* bytes = Take(sizeof(T));
+			Unsigned value = 0;
+			for (size_t n = 0; n < sizeof(T); ++n)
+			{
+				value = Unsigned(Unsigned(value << 8) | bytes[n]);
+			}
+			return static_cast<T>(value);
+		}
+
+		//----------------------------------------------------------------------------------------------
+		// Signed 8.24 fixed point, used by the path points.
+		float ReadFixed8_24()
+		{
+			return float(Read<int>()) / float(1 << 24);
+		}
+
+		//----------------------------------------------------------------------------------------------
+		// Four characters signature or key, such as "8BIM" or "lsct".
+		std::string ReadKey()
+		{
+			return std::string(reinterpret_cast<const char*>(Take(4)), 4);
+		}
+
+		//----------------------------------------------------------------------------------------------
+		// Pascal string, the length byte included the whole is padded to a multiple of alignment.
+		std::string ReadPascalString(size_t alignment)
+		{
+			const size_t size = Read<unsigned char>();
+			std::string value(reinterpret_cast<const char*>(Take(size)), size);
+			const size_t padded = (size + 1 + alignment - 1) / alignment * alignment;
+			Skip(padded - size - 1);
+			return value;
+		}
+
+		//----------------------------------------------------------------------------------------------
+		void ReadBytes(void* destination, size_t size)
+		{
+			memcpy(destination, Take(size), size);
+		}
+
+		//----------------------------------------------------------------------------------------------
+		// Pointer on the next bytes, valid as long as the underlying buffer is.
+		const unsigned char* Take(size_t size)
+		{
+			Require(size);
+			const unsigned char* bytes = this->Begin + this->Position;
+			this->Position += size;
+			return bytes;
+		}
+
+		//----------------------------------------------------------------------------------------------
+		void Skip(size_t size)
+		{
+			Require(size);
+			this->Position += size;
+		}
+
+		//----------------------------------------------------------------------------------------------
+		// Cursor on the next length bytes, the current cursor moves after them.
+		BigEndianCursor Sub(size_t length)
+		{
+			Require(length);
+			BigEndianCursor section(this->Begin + this->Position, length, Offset());
+			this->Position += length;
+			return section;
+		}
+
+		//----------------------------------------------------------------------------------------------
+		void Seek(size_t position)
+		{
+			if (position > this->Length) throw std::out_of_range("BigEndianCursor: seek past the end of the section");
+			this->Position = position;
+		}
+
+		//----------------------------------------------------------------------------------------------
+		// Seek to a position given as an Offset(), from the start of the whole buffer.
+		void SeekOffset(unsigned long long offset)
+		{
+			if (offset < this->Origin) throw std::out_of_range("BigEndianCursor: seek before the start of the section");
+			Seek(size_t(offset - this->Origin));
+		}
+
+		size_t Tell() const { return this->Position; }
+		size_t Size() const { return this->Length; }
+		size_t Remaining() const { return this->Length - this->Position; }
+		bool AtEnd() const { return this->Position >= this->Length; }
+
+		// Position in the whole buffer the first cursor was made from.
+		unsigned long long Offset() const { return this->Origin + this->Position; }
+		const unsigned char* Data() const { return this->Begin + this->Position; }
+
+	private:
+		const unsigned char* Begin = nullptr;
+		size_t Length = 0;
+		size_t Position = 0;
+		unsigned long long Origin = 0;
+
+		//----------------------------------------------------------------------------------------------
+		void Require(size_t size) const
+		{
+			if (size > this->Length - this->Position) throw std::out_of_range("BigEndianCursor: read past the end of the section");
+		}
+	};
+}
+
+#endif // BIGENDIANCURSOR_H
@@ -0,0 +1,170 @@
+//----------------------------------------------------------------------------------------------
+// ===============================================
+//  Copyright (C) 2026, E.D. Films.
+//  All Rights Reserved.
+// ===============================================
+//  Unauthorized copying of this file, via any medium is strictly prohibited
+//  Proprietary and confidential
+//
+//  @file contentHash.h
+//  @author Michaelson Britt
+//  @date 16-10-2026
+//
+//  @section DESCRIPTION
+//  Fast 64-bit hash of byte ranges, the XXH64 algorithm fed piece by piece.
+//
+//----------------------------------------------------------------------------------------------
+
+#ifndef CONTENTHASH_H
+#define CONTENTHASH_H
+
+#include <cstddef>
+#include <cstring>
+
+namespace util
+{
+	//----------------------------------------------------------------------------------------------
+	// Update can be called any number of times, the digest only depends on the concatenated bytes.
+	// Not meant for security, only to tell whether content changed.
+	class ContentHash
+	{
+	public:
+		explicit ContentHash(unsigned long long seed = 0)
+		{
+			this->Lanes[0] = seed + PRIME_1 + PRIME_2;
+			this->Lanes[1] = seed + PRIME_2;
+			this->Lanes[2] = seed;
+			this->Lanes[3] = seed - PRIME_1;
+			this->Seed = seed;
+		}
+
+		void Update(const unsigned char* data, size_t size)
+		{
+			this->Total += size;
+
+			// Complete the pending stripe first.
+			if (this->Pending > 0)
+			{
+				const size_t count = size < STRIPE - this->Pending ? size : STRIPE - this->Pending;
+				memcpy(this->Buffer + this->Pending, data, count);
+				this->Pending += count;
+				data += count;
+				size -= count;
+				if (this->Pending < STRIPE) return;
+				Consume(this->Buffer);
+				this->Pending = 0;
+			}
+
+			// The lanes stay in registers over the bulk of the bytes.
+			unsigned long long lanes[4] = { this->Lanes[0], this->Lanes[1], this->Lanes[2], this->Lanes[3] };
+			for (; size >= STRIPE; data += STRIPE, size -= STRIPE)
+			{
+				lanes[0] = Round(lanes[0], Load64(data));
+				lanes[1] = Round(lanes[1], Load64(data + 8));
+				lanes[2] = Round(lanes[2], Load64(data + 16));
+				lanes[3] = Round(lanes[3], Load64(data + 24));
+			}
+			for (int i = 0; i < 4; ++i) this->Lanes[i] = lanes[i];
+
+			memcpy(this->Buffer, data, size);
+			this->Pending = size;
+		}
+
+		unsigned long long Digest() const
+		{
+			unsigned long long hash;
+			if (this->Total >= STRIPE)
+			{
+				hash = RotateLeft(this->Lanes[0], 1) + RotateLeft(this->Lanes[1], 7) + RotateLeft(this->Lanes[2], 12) + RotateLeft(this->Lanes[3], 18);
+				for (int i = 0; i < 4; ++i)
+				{
+					hash = (hash ^ Round(0, this->Lanes[i])) * PRIME_1 + PRIME_4;
+				}
+			}
+			else
+			{
+				hash = this->Seed + PRIME_5;
+			}
+			hash += this->Total;
+
+			// Tail of less than a stripe.
+			const unsigned char* tail = this->Buffer;
+			size_t remaining = this->Pending;
+			for (; remaining >= 8; tail += 8, remaining -= 8)
+			{
+				hash = RotateLeft(hash ^ Round(0, Load64(tail)), 27) * PRIME_1 + PRIME_4;
+			}
+			if (remaining >= 4)
+			{
+				hash = RotateLeft(hash ^ (Load32(tail) * PRIME_1), 23) * PRIME_2 + PRIME_3;
+				tail += 4;
+				remaining -= 4;
+			}
+			for (; remaining > 0; ++tail, --remaining)
+			{
+				hash = RotateLeft(hash ^ (*tail * PRIME_5), 11) * PRIME_1;
+			}
+
+			hash ^= hash >> 33;
+			hash *= PRIME_2;
+			hash ^= hash >> 29;
+			hash *= PRIME_3;
+			hash ^= hash >> 32;
+			return hash;
+		}
+
+		static unsigned long long Of(const unsigned char* data, size_t size, unsigned long long seed = 0)
+		{
+			ContentHash hash(seed);
+			hash.Update(data, size);
+			return hash.Digest();
+		}
+
+	private:
+		static const unsigned long long PRIME_1 = 0x9E3779B185EBCA87ull;
+		static const unsigned long long PRIME_2 = 0xC2B2AE3D27D4EB4Full;
+		static const unsigned long long PRIME_3 = 0x165667B19E3779F9ull;
+		static const unsigned long long PRIME_4 = 0x85EBCA77C2B2AE63ull;
+		static const unsigned long long PRIME_5 = 0x27D4EB2F165667C5ull;
+		static const size_t STRIPE = 32;
+
+		unsigned long long Lanes[4];
+		unsigned long long Seed;
+		unsigned long long Total = 0;
+		unsigned char Buffer[STRIPE];
+		size_t Pending = 0;
+
+		static unsigned long long RotateLeft(unsigned long long value, int bits)
+		{
+			return (value << bits) | (value >> (64 - bits));
+		}
+
+		static unsigned long long Round(unsigned long long lane, unsigned long long input)
+		{
+			return RotateLeft(lane + input * PRIME_2, 31) * PRIME_1;
+		}
+
+		// Little-endian as the reference algorithm, which the plugin platforms are.
+		static unsigned long long Load64(const unsigned char* bytes)
+		{
+			unsigned long long value;
+			memcpy(&value, bytes, 8);
+			return value;
+		}
+
+		static unsigned long long Load32(const unsigned char* bytes)
+		{
+			return (unsigned long long)bytes[0] | (unsigned long long)bytes[1] << 8 | (unsigned long long)bytes[2] << 16 | (unsigned long long)bytes[3] << 24;
+		}
+
+		void Consume(const unsigned char* stripe)
+		{
+			for (int i = 0; i < 4; ++i)
+			{
+				this->Lanes[i] = Round(this->Lanes[i], Load64(stripe + i * 8));
+			}
+		}
+	};
+}
+
+#endif // CONTENTHASH_H
@@ -0,0 +1,124 @@
+//----------------------------------------------------------------------------------------------
+// ===============================================
+//  Copyright (C) 2026, E.D. Films.
+//  All Rights Reserved.
+// ===============================================
+//  Unauthorized copying of this file, via any medium is strictly prohibited
+//  Proprietary and confidential
+//
+//  @file parallel.h
+//  @author Michaelson Britt
+//  @date 16-10-2026
+//
+//  @section DESCRIPTION
+//  Minimal worker pool running independent tasks over an index range.
+//
+//----------------------------------------------------------------------------------------------
+
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace util
+{
+	//----------------------------------------------------------------------------------------------
+	class Parallel
+	{
+	public:
+		//----------------------------------------------------------------------------------------------
+		// Thread count to use for a requested count, 0 meaning one per hardware thread.
+		static unsigned ThreadCount(unsigned requested)
+		{
+			if (requested > 0) return requested;
+			const unsigned hardware = std::thread::hardware_concurrency();
+			return hardware > 0 ? hardware : 1;
+		}
+
+		//----------------------------------------------------------------------------------------------
+		// Run task(index) for every index in [0, count). With more than one thread the tasks run on
+		// workers while the calling thread calls poll() regularly until they are all done, so
+		// callbacks which aren't thread safe (progress, UI) stay on the calling thread.
+		// The first exception thrown by a task is rethrown on the calling thread.
+		static void For(size_t count, unsigned threadCount, std::function<void(size_t)> const& task, std::function<void()> const& poll = nullptr)
+		{
+			if (count == 0) return;
+
+			const size_t workerCount = std::min<size_t>(ThreadCount(threadCount), count);
+			if (workerCount <= 1)
+			{
+				for (size_t index = 0; index < count; ++index)
+				{
+					task(index);
+					if (poll) poll();
+				}
+				return;
+			}
+
+			std::atomic<size_t> next(0);
+			std::atomic<bool> failed(false);
+			size_t finishedWorkers = 0;
+			std::exception_ptr error;
+			std::mutex lock;
+			std::condition_variable finished;
+
+			auto worker = [&]()
+			{
+				for (size_t index = next++; index < count && !failed; index = next++)
+				{
+					try
+					{
+						task(index);
+					}
+					catch (...)
+					{
+						std::lock_guard<std::mutex> guard(lock);
+						if (!error) error = std::current_exception();
+						failed = true;
+					}
+				}
+
+				std::lock_guard<std::mutex> guard(lock);
+				++finishedWorkers;
+				finished.notify_one();
+			};
+
+			std::vector<std::thread> workers;
+			workers.reserve(workerCount);
+			for (size_t i = 0; i < workerCount; ++i)
+			{
+				workers.emplace_back(worker);
+			}
+
+			{
+				std::unique_lock<std::mutex> guard(lock);
+				while (finishedWorkers < workerCount)
+				{
+					finished.wait_for(guard, std::chrono::milliseconds(20));
+					if (!poll) continue;
+
+					guard.unlock();
+					poll();
+					guard.lock();
+				}
+			}
+
+			for (auto& thread : workers)
+			{
+				thread.join();
+			}
+			if (poll) poll();
+			if (error) std::rethrow_exception(error);
+		}
+	};
+}
+
+#endif // PARALLEL_H
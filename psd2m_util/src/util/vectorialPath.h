@@ -23,6 +23,7 @@
 namespace util
 {
 	//----------------------------------------------------------------------------------------------
+	// One point of a path as read from the file, copied in and out of a PathStore.
 	struct PathPoints
 	{
 		bool IsLinked = false;
@@ -34,15 +35,132 @@ namespace util
 		~PathPoints() {};
 	};
 
+	struct PathStore;
+
 	//----------------------------------------------------------------------------------------------
-	struct PathRecord
+	// One subpath of a PathStore, valid as long as the store is alive and unchanged.
+	struct PathView
 	{
+		PathStore const* Store = nullptr;
+		size_t First = 0; // Index of the first point in the store arrays.
+		size_t Count = 0;
 		bool IsClosedPath = false;
-		std::vector<PathPoints*> Points;
 
-		PathRecord() {};
-		~PathRecord() {};
+		size_t Size() const { return Count; }
+		Vector2F AnchorPoint(size_t i) const;
+		Vector2F SegIn(size_t i) const;
+		Vector2F SegOut(size_t i) const;
+		bool IsLinked(size_t i) const;
+	};
+
+	//----------------------------------------------------------------------------------------------
+	// Every subpath of a layer or path resource, one array per point attribute. The points of a
+	// subpath are consecutive, from PathFirst[i] to PathFirst[i + 1] or the end of the arrays.
+	struct PathStore
+	{
+		std::vector<float> AnchorX;
+		std::vector<float> AnchorY;
+		std::vector<float> SegInX;
+		std::vector<float> SegInY;
+		std::vector<float> SegOutX;
+		std::vector<float> SegOutY;
+		std::vector<unsigned char> Linked;
+		std::vector<size_t> PathFirst;
+		std::vector<unsigned char> PathClosed;
+
+		size_t Size() const { return PathFirst.size(); }
+		bool Empty() const { return PathFirst.empty(); }
+		size_t PointCount() const { return AnchorX.size(); }
+
+		PathView operator[](size_t i) const
+		{
+			PathView view;
+			view.Store = this;
+			view.First = PathFirst[i];
+			view.Count = (i + 1 < PathFirst.size() ? PathFirst[i + 1] : AnchorX.size()) - PathFirst[i];
+			view.IsClosedPath = PathClosed[i] != 0;
+			return view;
+		}
+
+		// A new subpath, the previous one being ended first.
+		void BeginPath(bool isClosed)
+		{
+			EndPath();
+			PathFirst.push_back(AnchorX.size());
+			PathClosed.push_back(isClosed ? 1 : 0);
+		}
+
+		// Points before any BeginPath make an open subpath.
+		void AddPoint(PathPoints const& point)
+		{
+			if (PathFirst.empty()) BeginPath(false);
+			AnchorX.push_back(point.AnchorPoint.x);
+			AnchorY.push_back(point.AnchorPoint.y);
+			SegInX.push_back(point.SegIn.x);
+			SegInY.push_back(point.SegIn.y);
+			SegOutX.push_back(point.SegOut.x);
+			SegOutY.push_back(point.SegOut.y);
+			Linked.push_back(point.IsLinked ? 1 : 0);
+		}
+
+		// Drop the last subpath when it has no point, or is closed with 2 points or less.
+		void EndPath()
+		{
+			if (Empty()) return;
+			const PathView last = (*this)[Size() - 1];
+			if (last.Count > 0 && !(last.IsClosedPath && last.Count <= 2)) return;
+
+			const size_t first = PathFirst.back();
+			for (auto attribute : { &AnchorX, &AnchorY, &SegInX, &SegInY, &SegOutX, &SegOutY })
+			{
+				attribute->resize(first);
+			}
+			Linked.resize(first);
+			PathFirst.pop_back();
+			PathClosed.pop_back();
+		}
+
+		void Clear()
+		{
+			*this = PathStore();
+		}
+
+		//------------------------------------------------------------------------------------------
+		// Subpaths by value, for (PathView path : store).
+		struct Iterator
+		{
+			PathStore const* Store;
+			size_t Index;
+
+			PathView operator*() const { return (*Store)[Index]; }
+			Iterator& operator++() { ++Index; return *this; }
+			bool operator!=(Iterator const& other) const { return Index != other.Index; }
+		};
+
+		Iterator begin() const { return Iterator{ this, 0 }; }
+		Iterator end() const { return Iterator{ this, Size() }; }
 	};
+
+	//----------------------------------------------------------------------------------------------
+	inline Vector2F PathView::AnchorPoint(size_t i) const
+	{
+		return Vector2F(Store->AnchorX[First + i], Store->AnchorY[First + i]);
+	}
+
+	inline Vector2F PathView::SegIn(size_t i) const
+	{
+		return Vector2F(Store->SegInX[First + i], Store->SegInY[First + i]);
+	}
+
+	inline Vector2F PathView::SegOut(size_t i) const
+	{
+		return Vector2F(Store->SegOutX[First + i], Store->SegOutY[First + i]);
+	}
+
+	inline bool PathView::IsLinked(size_t i) const
+	{
+		return Store->Linked[First + i] != 0;
+	}
 }
 
 #endif // VECTORIELPATH_H